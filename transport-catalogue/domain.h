@@ -1,7 +1,9 @@
 #pragma once
 #include "geo.h"
 
-#include <set>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <string>
 #include <string_view>
 #include <unordered_set>
@@ -10,30 +12,121 @@
 
 using sv = std::string_view;
 
+// Имена остановок и автобусов хранятся в StringPool справочника
 struct Stop {
 
-	std::string name;
+	sv name;
 	geo::Coordinates coordinates; // from geo.h
 };
 using StopPtr = const Stop*;
 
+// Полный путь маршрута поверх его остановок, без копирования.
+// Некольцевой маршрут из n остановок проходится до конечной и обратно: 2n - 1 остановка пути.
+template <typename It>
+class RoutePath {
+public:
+	using ValueType = typename std::iterator_traits<It>::value_type;
+
+	class Iterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = ValueType;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const value_type*;
+		using reference = const value_type&;
+
+		Iterator(It first, size_t stops_count, size_t index)
+			: first_(first)
+			, stops_count_(stops_count)
+			, index_(index) {
+		}
+		reference operator*() const {
+			return At(first_, stops_count_, index_);
+		}
+		Iterator& operator++() {
+			++index_;
+			return *this;
+		}
+		Iterator operator++(int) {
+			Iterator result = *this;
+			++index_;
+			return result;
+		}
+		bool operator==(const Iterator& other) const {
+			return index_ == other.index_;
+		}
+		bool operator!=(const Iterator& other) const {
+			return index_ != other.index_;
+		}
+
+	private:
+		It first_;
+		size_t stops_count_;
+		size_t index_;
+	};
+
+	RoutePath(It first, It last, bool is_roundtrip)
+		: first_(first)
+		, stops_count_(static_cast<size_t>(std::distance(first, last)))
+		, is_roundtrip_(is_roundtrip) {
+	}
+
+	Iterator begin() const {
+		return {first_, stops_count_, 0};
+	}
+	Iterator end() const {
+		return {first_, stops_count_, size()};
+	}
+
+	size_t size() const {
+		return is_roundtrip_ || stops_count_ == 0 ? stops_count_ : 2 * stops_count_ - 1;
+	}
+	const ValueType& operator[](size_t index) const {
+		return At(first_, stops_count_, index);
+	}
+
+private:
+	// После конечной остановки путь идёт по остановкам в обратном порядке
+	static const ValueType& At(It first, size_t stops_count, size_t index) {
+		return index < stops_count ? first[index] : first[2 * stops_count - 2 - index];
+	}
+
+	It first_;
+	size_t stops_count_;
+	bool is_roundtrip_;
+};
+
 struct Bus {
 
-	std::string name;
-	std::vector<StopPtr> route;
-	std::vector<StopPtr> edge_stops;
+	sv name;
+	// Остановки в порядке из запроса. Обратный ход некольцевого маршрута не хранится.
+	std::vector<StopPtr> stops;
+	bool is_roundtrip = false;
+
+	RoutePath<std::vector<StopPtr>::const_iterator> GetRoute() const {
+		return {stops.begin(), stops.end(), is_roundtrip};
+	}
 };
 using BusPtr = const Bus*;
 
+// Номера остановок и автобусов в неизменяемом снимке справочника
+using StopId = uint32_t;
+using BusId = uint32_t;
+
 struct RouteSettings {
 
 	double wait_time = 0;
 	double velocity = 0;
+	// Пешие участки поездок между произвольными точками: скорость в км/ч
+	// и наибольшее расстояние пешком до остановки в метрах
+	double pedestrian_velocity = 5;
+	double walk_radius = 1000;
 };
+// Автобусы через остановку: при начальной загрузке в порядке добавления,
+// после TransportCatalogue::Finalize() отсортированы по имени и остаются отсортированными.
 struct StopInfo {
 
-	std::set<sv> through_buses;
-	std::vector<size_t> vertexes;
+	std::vector<BusPtr> through_buses;
 };
 
 struct BusInfo{
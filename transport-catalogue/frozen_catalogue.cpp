@@ -0,0 +1,342 @@
+#include "frozen_catalogue.h"
+#include "transport_catalogue.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <unordered_map>
+
+using namespace std;
+
+namespace {
+
+const size_t bits_per_word = 64;
+// Номер BusId в списке занимает 32 бита: строка битов выгоднее, если автобусов у остановки
+// не меньше 1/32 от всех
+const size_t bits_per_bus_id = 32;
+const uint32_t no_row = numeric_limits<uint32_t>::max();
+
+int CountBits(uint64_t word){
+#if defined(__GNUC__)
+    return __builtin_popcountll(word);
+#else
+    int count = 0;
+    for (; word != 0; word &= word - 1){
+        ++count;
+    }
+    return count;
+#endif
+}
+
+int CountTrailingZeros(uint64_t word){
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    int count = 0;
+    for (; (word & 1) == 0; word >>= 1){
+        ++count;
+    }
+    return count;
+#endif
+}
+
+}  // namespace
+
+FrozenCatalogue::FrozenCatalogue(const TransportCatalogue& db)
+: route_settings_(db.GetRouteSettings()){
+
+    auto all_stops = db.GetAllStops();
+    vector<StopPtr> stops(all_stops.begin(), all_stops.end());
+    sort(stops.begin(), stops.end(),
+        [](StopPtr lhs, StopPtr rhs){return lhs->name < rhs->name;});
+    auto all_buses = db.GetAllBuses();
+    vector<BusPtr> buses(all_buses.begin(), all_buses.end());
+    sort(buses.begin(), buses.end(),
+        [](BusPtr lhs, BusPtr rhs){return lhs->name < rhs->name;});
+
+    unordered_map<StopPtr, StopId> stop_ids;
+    stop_ids.reserve(stops.size());
+    for (StopPtr stop : stops){
+        stop_ids.emplace(stop, static_cast<StopId>(stop_ids.size()));
+    }
+    unordered_map<BusPtr, BusId> bus_ids;
+    bus_ids.reserve(buses.size());
+    for (BusPtr bus : buses){
+        bus_ids.emplace(bus, static_cast<BusId>(bus_ids.size()));
+    }
+
+    stop_bus_words_ = (buses.size() + bits_per_word - 1) / bits_per_word;
+    stop_bus_rows_.reserve(stops.size());
+    stop_coordinates_.reserve(stops.size());
+    stop_buses_offsets_.reserve(stops.size() + 1);
+    stop_buses_offsets_.push_back(0);
+    for (StopPtr stop : stops){
+        stop_names_.Add(stop->name);
+        stop_coordinates_.push_back(stop->coordinates);
+
+        auto first = stop_buses_.size();
+        for (BusPtr bus : db.GetStopInfo(stop->name)->through_buses){
+            stop_buses_.push_back(bus_ids.at(bus));
+        }
+        sort(stop_buses_.begin() + first, stop_buses_.end());
+        stop_buses_offsets_.push_back(static_cast<uint32_t>(stop_buses_.size()));
+
+        const size_t count = stop_buses_.size() - first;
+        if (count == 0 || count * bits_per_bus_id < buses.size()){
+            stop_bus_rows_.push_back(no_row);
+            continue;
+        }
+        stop_bus_rows_.push_back(static_cast<uint32_t>(stop_bus_bits_.size() / stop_bus_words_));
+        stop_bus_bits_.resize(stop_bus_bits_.size() + stop_bus_words_, 0);
+        uint64_t* bits = stop_bus_bits_.data() + stop_bus_bits_.size() - stop_bus_words_;
+        for (size_t i = first; i < stop_buses_.size(); ++i){
+            bits[stop_buses_[i] / bits_per_word] |= uint64_t{1} << (stop_buses_[i] % bits_per_word);
+        }
+    }
+
+    stop_names_.BuildIndex();
+    stop_index_ = geo::GridIndex(stop_coordinates_);
+
+    bus_info_.reserve(buses.size());
+    bus_is_roundtrip_.reserve(buses.size());
+    bus_route_offsets_.reserve(buses.size() + 1);
+    bus_route_offsets_.push_back(0);
+    bus_distances_offsets_.reserve(buses.size() + 1);
+    bus_distances_offsets_.push_back(0);
+    for (BusPtr bus : buses){
+        bus_names_.Add(bus->name);
+        bus_info_.push_back(*db.GetBusInfo(bus->name));
+
+        bus_is_roundtrip_.push_back(bus->is_roundtrip);
+
+        for (StopPtr stop : bus->stops){
+            bus_routes_.push_back(stop_ids.at(stop));
+        }
+        auto route = bus->GetRoute();
+        for (size_t index = 1; index < route.size(); ++index){
+            bus_distances_.push_back(db.GetDistance(route[index - 1], route[index]).road);
+        }
+        bus_route_offsets_.push_back(static_cast<uint32_t>(bus_routes_.size()));
+        bus_distances_offsets_.push_back(static_cast<uint32_t>(bus_distances_.size()));
+    }
+    bus_names_.BuildIndex();
+}
+
+size_t FrozenCatalogue::GetStopCount() const {
+    return stop_coordinates_.size();
+}
+
+optional<StopId> FrozenCatalogue::FindStop(sv name) const {
+    return stop_names_.Find(name);
+}
+
+sv FrozenCatalogue::GetStopName(StopId id) const {
+    return stop_names_[id];
+}
+
+geo::Coordinates FrozenCatalogue::GetStopCoordinates(StopId id) const {
+    return stop_coordinates_[id];
+}
+
+FrozenCatalogue::BusRange FrozenCatalogue::GetBusesByStop(StopId id) const {
+    return {stop_buses_.begin() + stop_buses_offsets_[id],
+            stop_buses_.begin() + stop_buses_offsets_[id + 1]};
+}
+
+// Если строки битов есть у всех остановок, они пересекаются побитовым И.
+// Иначе берётся самый короткий список и из него отбираются автобусы,
+// которые есть у остальных остановок: по биту строки или слиянием отсортированных списков.
+vector<BusId> FrozenCatalogue::FindCommonBuses(const vector<StopId>& stops) const {
+    vector<BusId> result;
+    if (stops.empty()){
+        return result;
+    }
+    const bool all_rows = all_of(stops.begin(), stops.end(), [this](StopId stop){
+        return stop_bus_rows_[stop] != no_row;
+    });
+    if (all_rows){
+        // Цикл векторизуется компилятором
+        auto row = [this](StopId stop){ return stop_bus_bits_.data() + size_t{stop_bus_rows_[stop]} * stop_bus_words_; };
+        vector<uint64_t> common(row(stops.front()), row(stops.front()) + stop_bus_words_);
+        for (size_t i = 1; i < stops.size(); ++i){
+            const uint64_t* bits = row(stops[i]);
+            for (size_t word = 0; word < stop_bus_words_; ++word){
+                common[word] &= bits[word];
+            }
+        }
+
+        size_t count = 0;
+        for (uint64_t bits : common){
+            count += CountBits(bits);
+        }
+        result.reserve(count);
+        for (size_t word = 0; word < stop_bus_words_; ++word){
+            for (uint64_t bits = common[word]; bits != 0; bits &= bits - 1){
+                result.push_back(static_cast<BusId>(word * bits_per_word + CountTrailingZeros(bits)));
+            }
+        }
+        return result;
+    }
+
+    auto size = [this](StopId stop){ return stop_buses_offsets_[stop + 1] - stop_buses_offsets_[stop]; };
+    const StopId shortest = *min_element(stops.begin(), stops.end(), [&size](StopId lhs, StopId rhs){
+        return size(lhs) < size(rhs);
+    });
+    BusRange buses = GetBusesByStop(shortest);
+    result.assign(buses.begin(), buses.end());
+    vector<BusId> merged;
+    for (StopId stop : stops){
+        if (stop == shortest || result.empty()){
+            continue;
+        }
+        if (stop_bus_rows_[stop] != no_row){
+            const uint64_t* bits = stop_bus_bits_.data() + size_t{stop_bus_rows_[stop]} * stop_bus_words_;
+            result.erase(remove_if(result.begin(), result.end(), [bits](BusId bus){
+                return !(bits[bus / bits_per_word] >> (bus % bits_per_word) & 1);
+            }), result.end());
+        } else {
+            BusRange other = GetBusesByStop(stop);
+            merged.clear();
+            set_intersection(result.begin(), result.end(), other.begin(), other.end(), back_inserter(merged));
+            result.swap(merged);
+        }
+    }
+    return result;
+}
+
+vector<geo::Neighbour> FrozenCatalogue::FindNearestStops(geo::Coordinates point, size_t count) const {
+    return stop_index_.FindNearest(point, count);
+}
+
+vector<geo::Neighbour> FrozenCatalogue::FindStopsInRadius(geo::Coordinates point, double radius) const {
+    return stop_index_.FindInRadius(point, radius);
+}
+
+vector<StopId> FrozenCatalogue::FindStopsInBox(geo::Coordinates min, geo::Coordinates max) const {
+    return stop_index_.FindInBox(min, max);
+}
+
+pair<StopId, StopId> FrozenCatalogue::FindStopsByPrefix(sv prefix) const {
+    return stop_names_.FindPrefix(prefix);
+}
+
+size_t FrozenCatalogue::GetBusCount() const {
+    return bus_info_.size();
+}
+
+optional<BusId> FrozenCatalogue::FindBus(sv name) const {
+    return bus_names_.Find(name);
+}
+
+sv FrozenCatalogue::GetBusName(BusId id) const {
+    return bus_names_[id];
+}
+
+pair<BusId, BusId> FrozenCatalogue::FindBusesByPrefix(sv prefix) const {
+    return bus_names_.FindPrefix(prefix);
+}
+
+const BusInfo& FrozenCatalogue::GetBusInfo(BusId id) const {
+    return bus_info_[id];
+}
+
+FrozenCatalogue::RouteRange FrozenCatalogue::GetBusRoute(BusId id) const {
+    return {bus_routes_.begin() + bus_route_offsets_[id],
+            bus_routes_.begin() + bus_route_offsets_[id + 1],
+            bus_is_roundtrip_[id]};
+}
+
+FrozenCatalogue::DistanceRange FrozenCatalogue::GetBusRouteDistances(BusId id) const {
+    return {bus_distances_.begin() + bus_distances_offsets_[id],
+            bus_distances_.begin() + bus_distances_offsets_[id + 1]};
+}
+
+pair<StopId, StopId> FrozenCatalogue::GetBusEdgeStops(BusId id) const {
+    if (bus_route_offsets_[id] == bus_route_offsets_[id + 1]){
+        return {};
+    }
+    return {bus_routes_[bus_route_offsets_[id]], bus_routes_[bus_route_offsets_[id + 1] - 1]};
+}
+
+RouteSettings FrozenCatalogue::GetRouteSettings() const {
+    return route_settings_;
+}
+
+memory::Report FrozenCatalogue::GetMemoryUsage() const {
+    memory::Usage stops = stop_names_.GetMemoryUsage();
+    stops.bytes += memory::VectorBytes(stop_coordinates_)
+                 + memory::VectorBytes(stop_buses_offsets_)
+                 + memory::VectorBytes(stop_buses_);
+
+    memory::Usage buses = bus_names_.GetMemoryUsage();
+    buses.bytes += memory::VectorBytes(bus_info_)
+                 + memory::VectorBytes(bus_is_roundtrip_)
+                 + memory::VectorBytes(bus_route_offsets_)
+                 + memory::VectorBytes(bus_routes_)
+                 + memory::VectorBytes(bus_distances_offsets_)
+                 + memory::VectorBytes(bus_distances_);
+
+    return {{"stops"s, stops},
+            {"buses"s, buses},
+            {"stop_bus_bits"s, {memory::VectorBytes(stop_bus_rows_) + memory::VectorBytes(stop_bus_bits_),
+                                stop_bus_bits_.size()}},
+            {"spatial_index"s, stop_index_.GetMemoryUsage()}};
+}
+
+// NameTable__________________
+
+void FrozenCatalogue::NameTable::Add(sv name){
+    data.append(name);
+    offsets.push_back(static_cast<uint32_t>(data.size()));
+}
+
+size_t FrozenCatalogue::NameTable::Size() const {
+    return offsets.size() - 1;
+}
+
+sv FrozenCatalogue::NameTable::operator[](size_t index) const {
+    return sv(data).substr(offsets[index], offsets[index + 1] - offsets[index]);
+}
+
+void FrozenCatalogue::NameTable::BuildIndex(){
+    vector<sv> names;
+    names.reserve(Size());
+    for (size_t i = 0; i < Size(); ++i){
+        names.push_back((*this)[i]);
+    }
+    index = PerfectHash(names);
+}
+
+optional<uint32_t> FrozenCatalogue::NameTable::Find(sv name) const {
+    if (index.Empty()){
+        return nullopt;
+    }
+    uint32_t candidate = index(name);
+    if ((*this)[candidate] == name){
+        return candidate;
+    }
+    return nullopt;
+}
+
+pair<uint32_t, uint32_t> FrozenCatalogue::NameTable::FindPrefix(sv prefix) const {
+    // Первый номер из [first, last), для которого pred ложен
+    auto partition_point = [this](uint32_t first, uint32_t last, auto pred){
+        while (first < last){
+            uint32_t middle = first + (last - first) / 2;
+            if (pred((*this)[middle])){
+                first = middle + 1;
+            } else {
+                last = middle;
+            }
+        }
+        return first;
+    };
+    const uint32_t size = static_cast<uint32_t>(Size());
+    uint32_t first = partition_point(0, size, [prefix](sv name){ return name < prefix; });
+    uint32_t last = partition_point(first, size, [prefix](sv name){ return name.substr(0, prefix.size()) == prefix; });
+    return {first, last};
+}
+
+memory::Usage FrozenCatalogue::NameTable::GetMemoryUsage() const {
+    return {memory::StringBytes(data) + memory::VectorBytes(offsets) + index.GetMemoryUsage().bytes, Size()};
+}
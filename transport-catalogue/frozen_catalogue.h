@@ -0,0 +1,123 @@
+#pragma once
+
+#include "domain.h"
+#include "memory_usage.h"
+#include "perfect_hash.h"
+#include "ranges.h"
+#include "spatial_index.h"
+
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+class TransportCatalogue;
+
+// Неизменяемый снимок справочника, оптимизированный для чтения.
+// Остановки и автобусы пронумерованы в порядке возрастания имён, данные хранятся
+// в виде структуры массивов, связи остановка-автобус и автобус-остановка — в CSR-виде.
+// Снимок не ссылается на исходный справочник и не имеет изменяемого состояния,
+// поэтому читать его можно из любого числа потоков без блокировок.
+class FrozenCatalogue {
+public:
+	using RouteRange = RoutePath<std::vector<StopId>::const_iterator>;
+	using BusRange = ranges::Range<std::vector<BusId>::const_iterator>;
+	using DistanceRange = ranges::Range<std::vector<double>::const_iterator>;
+
+	explicit FrozenCatalogue(const TransportCatalogue& db);
+
+
+	size_t GetStopCount() const;
+
+	std::optional<StopId> FindStop(sv name) const;
+
+	sv GetStopName(StopId id) const;
+
+	geo::Coordinates GetStopCoordinates(StopId id) const;
+
+	// Автобусы через остановку в порядке возрастания номеров (и имён)
+	BusRange GetBusesByStop(StopId id) const;
+
+	// Автобусы, проходящие через все остановки stops, в порядке возрастания номеров.
+	// Для пустого списка остановок результат пуст.
+	std::vector<BusId> FindCommonBuses(const std::vector<StopId>& stops) const;
+
+	// Поиск остановок по координатам. В geo::Neighbour::index — номер остановки.
+	std::vector<geo::Neighbour> FindNearestStops(geo::Coordinates point, size_t count) const;
+
+	std::vector<geo::Neighbour> FindStopsInRadius(geo::Coordinates point, double radius) const;
+
+	std::vector<StopId> FindStopsInBox(geo::Coordinates min, geo::Coordinates max) const;
+
+	// Остановки, имена которых начинаются с prefix: номера [first, last) в порядке имён
+	std::pair<StopId, StopId> FindStopsByPrefix(sv prefix) const;
+
+
+	size_t GetBusCount() const;
+
+	std::optional<BusId> FindBus(sv name) const;
+
+	sv GetBusName(BusId id) const;
+
+	// Автобусы, имена которых начинаются с prefix: номера [first, last) в порядке имён
+	std::pair<BusId, BusId> FindBusesByPrefix(sv prefix) const;
+
+	const BusInfo& GetBusInfo(BusId id) const;
+
+	// Полный путь автобуса, включая обратный ход некольцевых маршрутов.
+	// Хранятся только остановки из запроса, обратный ход вычисляется при обходе.
+	RouteRange GetBusRoute(BusId id) const;
+
+	// Дорожные расстояния между соседними остановками пути GetBusRoute()
+	DistanceRange GetBusRouteDistances(BusId id) const;
+
+	// Конечные остановки маршрута. Для автобуса без остановок не определены.
+	std::pair<StopId, StopId> GetBusEdgeStops(BusId id) const;
+
+
+	RouteSettings GetRouteSettings() const;
+
+	// Память данных остановок, автобусов и пространственного индекса
+	memory::Report GetMemoryUsage() const;
+
+private:
+	// Имена, сложенные подряд в одну строку. i-е имя занимает [offsets[i], offsets[i + 1]).
+	// Поиск по имени — совершенный хеш и одно сравнение строк.
+	struct NameTable {
+		std::string data;
+		std::vector<uint32_t> offsets{0};
+		PerfectHash index;
+
+		void Add(sv name);
+		// Вызывается после добавления всех имён
+		void BuildIndex();
+		size_t Size() const;
+		sv operator[](size_t index) const;
+		std::optional<uint32_t> Find(sv name) const;
+		// Имена отсортированы, поэтому подходящие под префикс идут подряд
+		std::pair<uint32_t, uint32_t> FindPrefix(sv prefix) const;
+		memory::Usage GetMemoryUsage() const;
+	};
+
+	NameTable stop_names_;
+	std::vector<geo::Coordinates> stop_coordinates_;
+	std::vector<uint32_t> stop_buses_offsets_;
+	std::vector<BusId> stop_buses_;
+	// Те же связи в виде битовых строк по stop_bus_words_ слов, но только для остановок
+	// с длинным списком автобусов: строка не больше списка, и вся память строк не больше stop_buses_.
+	// Бит bus в строке установлен, если автобус проходит через остановку.
+	size_t stop_bus_words_ = 0;
+	std::vector<uint32_t> stop_bus_rows_;
+	std::vector<uint64_t> stop_bus_bits_;
+	geo::GridIndex stop_index_;
+
+	NameTable bus_names_;
+	std::vector<BusInfo> bus_info_;
+	std::vector<bool> bus_is_roundtrip_;
+	std::vector<uint32_t> bus_route_offsets_;
+	std::vector<StopId> bus_routes_;
+	std::vector<uint32_t> bus_distances_offsets_;
+	std::vector<double> bus_distances_;
+
+	RouteSettings route_settings_;
+};
@@ -1,16 +1,89 @@
 #define _USE_MATH_DEFINES
 #include "geo.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace geo {
-const int radius_of_the_earth = 6371000;
+namespace {
+const double dr = M_PI / 180.0;
+}  // namespace
+
+UnitVector ToUnitVector(Coordinates point) {
+    const double cos_lat = std::cos(point.lat * dr);
+    return {cos_lat * std::cos(point.lng * dr),
+            cos_lat * std::sin(point.lng * dr),
+            std::sin(point.lat * dr)};
+}
+
+double ChordSquaredToDistance(double chord_squared) {
+    return 2.0 * std::asin(std::min(1.0, std::sqrt(chord_squared) / 2.0)) * radius_of_the_earth;
+}
+
+double DistanceToChordSquared(double distance) {
+    const double half_angle = std::min(distance / radius_of_the_earth, M_PI) / 2.0;
+    const double chord = 2.0 * std::sin(half_angle);
+    return chord * chord;
+}
+
 double ComputeDistance(Coordinates from, Coordinates to) {
-    using namespace std;
-    const double dr = M_PI / 180.0;
-    return acos(sin(from.lat * dr) * sin(to.lat * dr)
-                + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
-        * radius_of_the_earth;
+    const UnitVector origin = ToUnitVector(from);
+    const UnitVector point = ToUnitVector(to);
+    const double dx = point.x - origin.x;
+    const double dy = point.y - origin.y;
+    const double dz = point.z - origin.z;
+    return ChordSquaredToDistance(dx * dx + dy * dy + dz * dz);
+}
+
+void PreparedPoints::Reserve(size_t count) {
+    x_.reserve(count);
+    y_.reserve(count);
+    z_.reserve(count);
+}
+
+void PreparedPoints::Add(Coordinates point) {
+    const UnitVector vector = ToUnitVector(point);
+    x_.push_back(vector.x);
+    y_.push_back(vector.y);
+    z_.push_back(vector.z);
+}
+
+size_t PreparedPoints::Size() const {
+    return x_.size();
+}
+
+void PreparedPoints::ComputeChordsSquared(UnitVector origin, size_t first, size_t last, double* out) const {
+    const double* x = x_.data();
+    const double* y = y_.data();
+    const double* z = z_.data();
+    for (size_t i = first; i < last; ++i) {
+        const double dx = x[i] - origin.x;
+        const double dy = y[i] - origin.y;
+        const double dz = z[i] - origin.z;
+        out[i - first] = dx * dx + dy * dy + dz * dz;
+    }
+}
+
+void PreparedPoints::ComputeDistances(Coordinates from, size_t first, size_t last, double* out) const {
+    ComputeChordsSquared(ToUnitVector(from), first, last, out);
+    for (size_t i = 0; i < last - first; ++i) {
+        out[i] = ChordSquaredToDistance(out[i]);
+    }
+}
+
+memory::Usage PreparedPoints::GetMemoryUsage() const {
+    return {memory::VectorBytes(x_) + memory::VectorBytes(y_) + memory::VectorBytes(z_), x_.size()};
+}
+
+std::vector<double> ComputeDistances(Coordinates from, const std::vector<Coordinates>& to) {
+    PreparedPoints points;
+    points.Reserve(to.size());
+    for (Coordinates point : to) {
+        points.Add(point);
+    }
+    std::vector<double> result(to.size());
+    points.ComputeDistances(from, 0, to.size(), result.data());
+    return result;
 }
 
-}  // namespace geo
\ No newline at end of file
+}  // namespace geo
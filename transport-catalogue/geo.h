@@ -1,8 +1,14 @@
 #pragma once
 
+#include "memory_usage.h"
+
 #include <cmath>
+#include <cstddef>
+#include <vector>
 
 namespace geo{
+inline const int radius_of_the_earth = 6371000;
+
 struct Coordinates {
     double lat;
     double lng;
@@ -19,5 +25,50 @@ struct Distance {
     double road;
 };
 
+// Точка на сфере единичного радиуса
+struct UnitVector {
+    double x;
+    double y;
+    double z;
+};
+
+UnitVector ToUnitVector(Coordinates point);
+
+// Длина дуги в метрах по квадрату хорды между единичными векторами: 2 * asin(chord / 2).
+// В отличие от формулы через acos она не теряет точность на коротких расстояниях.
+double ChordSquaredToDistance(double chord_squared);
+
+double DistanceToChordSquared(double distance);
+
+// Расстояние по дуге большого круга через хорду.
+// Погрешность определяется округлением координат единичных векторов и не превышает 1 мм.
 double ComputeDistance(Coordinates from, Coordinates to);
-}
\ No newline at end of file
+
+// Точки в виде единичных векторов, по массиву на каждую ось.
+// Синусы и косинусы считаются один раз при добавлении точки, а расстояние
+// между точками сводится к длине хорды — только умножения и сложения,
+// которые компилятор векторизует.
+class PreparedPoints {
+public:
+    void Reserve(size_t count);
+    void Add(Coordinates point);
+    size_t Size() const;
+
+    // Квадраты хорд от origin до точек с номерами [first, last), записываются в out[0, last - first).
+    // Квадрат хорды монотонно растёт с расстоянием, поэтому годится для сравнения расстояний.
+    void ComputeChordsSquared(UnitVector origin, size_t first, size_t last, double* out) const;
+
+    // Расстояния в метрах от from до точек [first, last) с той же погрешностью, что у ComputeDistance
+    void ComputeDistances(Coordinates from, size_t first, size_t last, double* out) const;
+
+    memory::Usage GetMemoryUsage() const;
+
+private:
+    std::vector<double> x_;
+    std::vector<double> y_;
+    std::vector<double> z_;
+};
+
+// Расстояния от одной точки до многих одним пакетом
+std::vector<double> ComputeDistances(Coordinates from, const std::vector<Coordinates>& to);
+}
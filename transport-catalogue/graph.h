@@ -1,5 +1,6 @@
 #pragma once
 
+#include "memory_usage.h"
 #include "ranges.h"
 
 #include <cstdlib>
@@ -33,6 +34,7 @@ public:
     size_t GetEdgeCount() const;
     const Edge<Weight>& GetEdge(EdgeId edge_id) const;
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+    memory::Usage GetMemoryUsage() const;
 
 private:
     std::vector<Edge<Weight>> edges_;
@@ -82,4 +84,15 @@ DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
         throw std::domain_error(message);
     }
 }
+
+template <typename Weight>
+memory::Usage DirectedWeightedGraph<Weight>::GetMemoryUsage() const {
+    memory::Usage usage{memory::VectorBytes(edges_) + memory::HashTableBytes(incidence_lists_),
+                        edges_.size()};
+    for (const auto& [vertex, incidence_list] : incidence_lists_) {
+        usage.bytes += memory::VectorBytes(incidence_list);
+    }
+    return usage;
+}
+
 }  // namespace graph
\ No newline at end of file
@@ -1,80 +1,178 @@
 #include "json.h"
 
-#include <iterator>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace json {
 
 namespace {
 using namespace std::literals;
 
-Node LoadNode(std::istream& input);
-Node LoadString(std::istream& input);
+// Первый из символов Chars в [pos, end) или end. Если доступны AVX2 или SSE2,
+// текст проверяется по 32 или 16 байт за раз, остаток — по одному байту.
+template <char... Chars>
+const char* FindAnyOf(const char* pos, const char* end) {
+#if defined(__AVX2__)
+    for (; end - pos >= 32; pos += 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+        __m256i found = _mm256_setzero_si256();
+        ((found = _mm256_or_si256(found, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(Chars)))), ...);
+        if (const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(found)); mask != 0) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+#elif defined(__SSE2__)
+    for (; end - pos >= 16; pos += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        __m128i found = _mm_setzero_si128();
+        ((found = _mm_or_si128(found, _mm_cmpeq_epi8(block, _mm_set1_epi8(Chars)))), ...);
+        if (const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(found)); mask != 0) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; pos != end; ++pos) {
+        if (((*pos == Chars) || ...)) {
+            return pos;
+        }
+    }
+    return end;
+}
 
-std::string LoadLiteral(std::istream& input) {
-    std::string s;
-    while (std::isalpha(input.peek())) {
-        s.push_back(static_cast<char>(input.get()));
+// Разбор документа, целиком находящегося в памяти. Текст просматривается указателем,
+// без посимвольных обращений к потоку.
+class Parser {
+public:
+    explicit Parser(std::string_view input)
+        : pos_(input.data())
+        , end_(input.data() + input.size()) {
     }
-    return s;
+
+    Node LoadNode();
+
+    // Разбирает значение, сообщая обработчику о каждом элементе
+    void ParseNode(Handler& handler);
+
+    // Ключи и тексты значений корневого словаря; значения пропускаются без разбора
+    RootSections SplitRoot();
+
+    // Тексты элементов массива без их разбора
+    std::vector<std::string_view> SplitArray();
+
+private:
+    // Пропускает пробельные символы. Возвращает false, если текст закончился.
+    bool SkipSpaces() {
+        while (pos_ != end_ && std::isspace(static_cast<unsigned char>(*pos_))) {
+            ++pos_;
+        }
+        return pos_ != end_;
+    }
+
+    std::string_view LoadLiteral();
+    Node LoadArray();
+    Node LoadDict();
+    std::string LoadString();
+    // Строка без экранирования не копируется
+    std::string_view LoadStringView();
+    Node LoadBool();
+    Node LoadNull();
+    Node LoadNumber();
+    void ParseArray(Handler& handler);
+    void ParseDict(Handler& handler);
+    void SkipValue();
+    void SkipString();
+
+    const char* pos_;
+    const char* end_;
+    std::string unescaped_;
+};
+
+std::string_view Parser::LoadLiteral() {
+    const char* start = pos_;
+    while (pos_ != end_ && std::isalpha(static_cast<unsigned char>(*pos_))) {
+        ++pos_;
+    }
+    return {start, static_cast<size_t>(pos_ - start)};
 }
 
-Node LoadArray(std::istream& input) {
+Node Parser::LoadArray() {
     std::vector<Node> result;
 
-    for (char c; input >> c && c != ']';) {
-        if (c != ',') {
-            input.putback(c);
+    while (true) {
+        if (!SkipSpaces()) {
+            throw ParsingError("Array parsing error"s);
         }
-        result.push_back(LoadNode(input));
-    }
-    if (!input) {
-        throw ParsingError("Array parsing error"s);
+        const char c = *pos_;
+        if (c == ']') {
+            ++pos_;
+            break;
+        }
+        if (c == ',') {
+            ++pos_;
+        }
+        result.push_back(LoadNode());
     }
     return Node(std::move(result));
 }
 
-Node LoadDict(std::istream& input) {
+Node Parser::LoadDict() {
     Dict dict;
 
-    for (char c; input >> c && c != '}';) {
+    while (true) {
+        if (!SkipSpaces()) {
+            throw ParsingError("Dictionary parsing error"s);
+        }
+        const char c = *pos_++;
+        if (c == '}') {
+            break;
+        }
         if (c == '"') {
-            std::string key = LoadString(input).AsString();
-            if (input >> c && c == ':') {
-                if (dict.find(key) != dict.end()) {
-                    throw ParsingError("Duplicate key '"s + key + "' have been found");
-                }
-                dict.emplace(std::move(key), LoadNode(input));
-            } else {
-                throw ParsingError(": is expected but '"s + c + "' has been found"s);
+            std::string key = LoadString();
+            if (!SkipSpaces()) {
+                throw ParsingError("Dictionary parsing error"s);
+            }
+            if (*pos_ != ':') {
+                throw ParsingError(": is expected but '"s + *pos_ + "' has been found"s);
+            }
+            ++pos_;
+            if (dict.find(key) != dict.end()) {
+                throw ParsingError("Duplicate key '"s + key + "' have been found");
             }
+            dict.emplace(std::move(key), LoadNode());
         } else if (c != ',') {
             throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
         }
     }
-    if (!input) {
-        throw ParsingError("Dictionary parsing error"s);
-    }
     return Node(std::move(dict));
 }
 
-Node LoadString(std::istream& input) {
-    auto it = std::istreambuf_iterator<char>(input);
-    auto end = std::istreambuf_iterator<char>();
+std::string Parser::LoadString() {
     std::string s;
     while (true) {
-        if (it == end) {
+        // Символы без экранирования копируются в строку одним куском
+        const char* start = pos_;
+        pos_ = FindAnyOf<'"', '\\', '\n', '\r'>(pos_, end_);
+        s.append(start, pos_);
+
+        if (pos_ == end_) {
             throw ParsingError("String parsing error");
         }
-        const char ch = *it;
+        const char ch = *pos_++;
         if (ch == '"') {
-            ++it;
             break;
         } else if (ch == '\\') {
-            ++it;
-            if (it == end) {
+            if (pos_ == end_) {
                 throw ParsingError("String parsing error");
             }
-            const char escaped_char = *(it);
+            const char escaped_char = *pos_++;
             switch (escaped_char) {
                 case 'n':
                     s.push_back('\n');
@@ -94,114 +192,158 @@ Node LoadString(std::istream& input) {
                 default:
                     throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
             }
-        } else if (ch == '\n' || ch == '\r') {
-            throw ParsingError("Unexpected end of line"s);
         } else {
-            s.push_back(ch);
+            throw ParsingError("Unexpected end of line"s);
         }
-        ++it;
     }
 
-    return Node(std::move(s));
+    return s;
+}
+
+std::string_view Parser::LoadStringView() {
+    const char* start = pos_;
+    const char* special = FindAnyOf<'"', '\\', '\n', '\r'>(pos_, end_);
+    if (special != end_ && *special == '"') {
+        pos_ = special + 1;
+        return {start, static_cast<size_t>(special - start)};
+    }
+    unescaped_ = LoadString();
+    return unescaped_;
 }
 
-Node LoadBool(std::istream& input) {
-    const auto s = LoadLiteral(input);
+Node Parser::LoadBool() {
+    const auto s = LoadLiteral();
     if (s == "true"sv) {
         return Node{true};
     } else if (s == "false"sv) {
         return Node{false};
     } else {
-        throw ParsingError("Failed to parse '"s + s + "' as bool"s);
+        throw ParsingError("Failed to parse '"s + std::string(s) + "' as bool"s);
     }
 }
 
-Node LoadNull(std::istream& input) {
-    if (auto literal = LoadLiteral(input); literal == "null"sv) {
+Node Parser::LoadNull() {
+    if (auto literal = LoadLiteral(); literal == "null"sv) {
         return Node{nullptr};
     } else {
-        throw ParsingError("Failed to parse '"s + literal + "' as null"s);
+        throw ParsingError("Failed to parse '"s + std::string(literal) + "' as null"s);
     }
 }
 
-Node LoadNumber(std::istream& input) {
-    std::string parsed_num;
+// Степени десяти, точно представимые в double
+constexpr double POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
 
-    // Считывает в parsed_num очередной символ из input
-    auto read_char = [&parsed_num, &input] {
-        parsed_num += static_cast<char>(input.get());
-        if (!input) {
-            throw ParsingError("Failed to read number from stream"s);
-        }
+// Не более стольких значащих цифр мантисса точно представима в double
+constexpr int MAX_EXACT_DIGITS = 15;
+
+Node Parser::LoadNumber() {
+    const char* start = pos_;
+
+    // Цифры числа без точки: при короткой мантиссе и небольшом порядке число
+    // вычисляется одним точным умножением или делением, как у from_chars
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+
+    auto is_digit = [this] {
+        return pos_ != end_ && std::isdigit(static_cast<unsigned char>(*pos_));
     };
 
-    // Считывает одну или более цифр в parsed_num из input
-    auto read_digits = [&input, read_char] {
-        if (!std::isdigit(input.peek())) {
+    // Считывает одну или более цифр, передавая каждую в on_digit
+    auto read_digits = [this, &is_digit](auto on_digit) {
+        if (!is_digit()) {
             throw ParsingError("A digit is expected"s);
         }
-        while (std::isdigit(input.peek())) {
-            read_char();
+        while (is_digit()) {
+            on_digit(*pos_ - '0');
+            ++pos_;
+        }
+    };
+
+    auto add_digit = [&mantissa, &digits](int digit) {
+        if (++digits <= MAX_EXACT_DIGITS) {
+            mantissa = mantissa * 10 + digit;
         }
     };
 
-    if (input.peek() == '-') {
-        read_char();
+    const bool is_negative = pos_ != end_ && *pos_ == '-';
+    if (is_negative) {
+        ++pos_;
     }
     // Парсим целую часть числа
-    if (input.peek() == '0') {
-        read_char();
+    if (pos_ != end_ && *pos_ == '0') {
+        ++pos_;
         // После 0 в JSON не могут идти другие цифры
     } else {
-        read_digits();
+        read_digits(add_digit);
     }
 
     bool is_int = true;
     // Парсим дробную часть числа
-    if (input.peek() == '.') {
-        read_char();
-        read_digits();
+    if (pos_ != end_ && *pos_ == '.') {
+        ++pos_;
+        read_digits([&add_digit, &exponent](int digit) {
+            add_digit(digit);
+            --exponent;
+        });
         is_int = false;
     }
 
     // Парсим экспоненциальную часть числа
-    if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-        read_char();
-        if (ch = input.peek(); ch == '+' || ch == '-') {
-            read_char();
+    if (pos_ != end_ && (*pos_ == 'e' || *pos_ == 'E')) {
+        ++pos_;
+        bool is_exponent_negative = false;
+        if (pos_ != end_ && (*pos_ == '+' || *pos_ == '-')) {
+            is_exponent_negative = *pos_ == '-';
+            ++pos_;
         }
-        read_digits();
+        int explicit_exponent = 0;
+        read_digits([&explicit_exponent](int digit) {
+            // Большие порядки всё равно разбираются общим путём
+            explicit_exponent = std::min(explicit_exponent * 10 + digit, 10000);
+        });
+        exponent += is_exponent_negative ? -explicit_exponent : explicit_exponent;
         is_int = false;
     }
 
-    try {
-        if (is_int) {
-            // Сначала пробуем преобразовать строку в int
-            try {
-                return std::stoi(parsed_num);
-            } catch (...) {
-                // В случае неудачи, например, при переполнении
-                // код ниже попробует преобразовать строку в double
-            }
+    if (is_int) {
+        int value;
+        if (auto [ptr, ec] = std::from_chars(start, pos_, value); ec == std::errc{}) {
+            return value;
         }
-        return std::stod(parsed_num);
-    } catch (...) {
-        throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
+        // При переполнении int число читается как double
+    }
+
+    if (digits <= MAX_EXACT_DIGITS && exponent >= -22 && exponent <= 22) {
+        double value = static_cast<double>(mantissa);
+        value = exponent < 0 ? value / POWERS_OF_TEN[-exponent] : value * POWERS_OF_TEN[exponent];
+        return is_negative ? -value : value;
+    }
+
+    double value;
+    if (auto [ptr, ec] = std::from_chars(start, pos_, value); ec != std::errc{} || ptr != pos_) {
+        throw ParsingError("Failed to convert "s + std::string(start, pos_) + " to number"s);
     }
+    return value;
 }
 
-Node LoadNode(std::istream& input) {
-    char c;
-    if (!(input >> c)) {
+Node Parser::LoadNode() {
+    if (!SkipSpaces()) {
         throw ParsingError("Unexpected EOF"s);
     }
-    switch (c) {
+    switch (*pos_) {
         case '[':
-            return LoadArray(input);
+            ++pos_;
+            return LoadArray();
         case '{':
-            return LoadDict(input);
+            ++pos_;
+            return LoadDict();
         case '"':
-            return LoadString(input);
+            ++pos_;
+            return Node(LoadString());
         case 't':
             // Атрибут [[fallthrough]] (провалиться) ничего не делает, и является
             // подсказкой компилятору и человеку, что здесь программист явно задумывал
@@ -211,30 +353,225 @@ Node LoadNode(std::istream& input) {
             // литералов true либо false
             [[fallthrough]];
         case 'f':
-            input.putback(c);
-            return LoadBool(input);
+            return LoadBool();
+        case 'n':
+            return LoadNull();
+        default:
+            return LoadNumber();
+    }
+}
+
+void Parser::ParseArray(Handler& handler) {
+    handler.StartArray();
+    while (true) {
+        if (!SkipSpaces()) {
+            throw ParsingError("Array parsing error"s);
+        }
+        const char c = *pos_;
+        if (c == ']') {
+            ++pos_;
+            break;
+        }
+        if (c == ',') {
+            ++pos_;
+        }
+        ParseNode(handler);
+    }
+    handler.EndArray();
+}
+
+void Parser::ParseDict(Handler& handler) {
+    handler.StartDict();
+    while (true) {
+        if (!SkipSpaces()) {
+            throw ParsingError("Dictionary parsing error"s);
+        }
+        const char c = *pos_++;
+        if (c == '}') {
+            break;
+        }
+        if (c == '"') {
+            std::string_view key = LoadStringView();
+            if (!SkipSpaces()) {
+                throw ParsingError("Dictionary parsing error"s);
+            }
+            if (*pos_ != ':') {
+                throw ParsingError(": is expected but '"s + *pos_ + "' has been found"s);
+            }
+            ++pos_;
+            handler.Key(key);
+            ParseNode(handler);
+        } else if (c != ',') {
+            throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+        }
+    }
+    handler.EndDict();
+}
+
+void Parser::ParseNode(Handler& handler) {
+    if (!SkipSpaces()) {
+        throw ParsingError("Unexpected EOF"s);
+    }
+    switch (*pos_) {
+        case '[':
+            ++pos_;
+            ParseArray(handler);
+            break;
+        case '{':
+            ++pos_;
+            ParseDict(handler);
+            break;
+        case '"':
+            ++pos_;
+            handler.String(LoadStringView());
+            break;
+        case 't':
+            [[fallthrough]];
+        case 'f':
+            handler.Value(std::move(LoadBool().GetValue()));
+            break;
         case 'n':
-            input.putback(c);
-            return LoadNull(input);
+            handler.Value(std::move(LoadNull().GetValue()));
+            break;
         default:
-            input.putback(c);
-            return LoadNumber(input);
+            handler.Value(std::move(LoadNumber().GetValue()));
+            break;
+    }
+}
+
+// Пропускает значение, считая только скобки вне строк. Содержимое не проверяется:
+// текст между кавычками и скобками пропускается кусками, как в LoadString.
+void Parser::SkipValue() {
+    if (!SkipSpaces()) {
+        throw ParsingError("Unexpected EOF"s);
+    }
+    if (*pos_ != '"' && *pos_ != '[' && *pos_ != '{') {
+        // Число или литерал: до разделителя
+        while (pos_ != end_ && *pos_ != ',' && *pos_ != '}' && *pos_ != ']'
+               && !std::isspace(static_cast<unsigned char>(*pos_))) {
+            ++pos_;
+        }
+        return;
+    }
+    int depth = 0;
+    do {
+        pos_ = FindAnyOf<'"', '[', ']', '{', '}'>(pos_, end_);
+        if (pos_ == end_) {
+            throw ParsingError("Unexpected EOF"s);
+        }
+        const char c = *pos_++;
+        if (c == '"') {
+            SkipString();
+        } else if (c == '[' || c == '{') {
+            ++depth;
+        } else {
+            --depth;
+        }
+    } while (depth > 0);
+}
+
+// Пропускает строку после открывающей кавычки, не раскрывая экранирование
+void Parser::SkipString() {
+    while (true) {
+        pos_ = FindAnyOf<'"', '\\'>(pos_, end_);
+        if (pos_ == end_ || (*pos_ == '\\' && end_ - pos_ < 2)) {
+            throw ParsingError("String parsing error");
+        }
+        if (*pos_ == '"') {
+            ++pos_;
+            return;
+        }
+        pos_ += 2;
     }
 }
 
+RootSections Parser::SplitRoot() {
+    if (!SkipSpaces() || *pos_ != '{') {
+        throw ParsingError("Root must be a dict"s);
+    }
+    RootSections sections;
+    ++pos_;
+    while (true) {
+        if (!SkipSpaces()) {
+            throw ParsingError("Dictionary parsing error"s);
+        }
+        const char c = *pos_++;
+        if (c == '}') {
+            break;
+        }
+        if (c == '"') {
+            std::string key = LoadString();
+            if (!SkipSpaces() || *pos_ != ':') {
+                throw ParsingError("Dictionary parsing error"s);
+            }
+            ++pos_;
+            SkipSpaces();
+            const char* start = pos_;
+            SkipValue();
+            sections.emplace_back(std::move(key), std::string_view(start, pos_ - start));
+        } else if (c != ',') {
+            throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+        }
+    }
+    return sections;
+}
+
+std::vector<std::string_view> Parser::SplitArray() {
+    if (!SkipSpaces() || *pos_ != '[') {
+        throw ParsingError("Array is expected"s);
+    }
+    ++pos_;
+    std::vector<std::string_view> items;
+    while (true) {
+        if (!SkipSpaces()) {
+            throw ParsingError("Array parsing error"s);
+        }
+        if (*pos_ == ']') {
+            ++pos_;
+            break;
+        }
+        if (!items.empty()) {
+            if (*pos_ != ',') {
+                throw ParsingError(R"(',' is expected but ')"s + *pos_ + "' has been found"s);
+            }
+            ++pos_;
+            SkipSpaces();
+        }
+        const char* start = pos_;
+        SkipValue();
+        items.emplace_back(start, pos_ - start);
+    }
+    return items;
+}
+
+// Отступы выводятся кусками этой строки
+constexpr std::string_view SPACES = "                                "sv;
+
 struct PrintContext {
     std::ostream& out;
     int indent_step = 4;
     int indent = 0;
+    PrintMode mode = PrintMode::PRETTY;
 
     void PrintIndent() const {
-        for (int i = 0; i < indent; ++i) {
-            out.put(' ');
+        if (mode == PrintMode::COMPACT) {
+            return;
+        }
+        for (size_t left = indent; left > 0;) {
+            const size_t part = std::min(left, SPACES.size());
+            out.write(SPACES.data(), part);
+            left -= part;
+        }
+    }
+
+    void PrintNewLine() const {
+        if (mode == PrintMode::PRETTY) {
+            out.put('\n');
         }
     }
 
     PrintContext Indented() const {
-        return {out, indent_step, indent_step + indent};
+        return {out, indent_step, indent_step + indent, mode};
     }
 };
 
@@ -245,33 +582,42 @@ void PrintValue(const Value& value, const PrintContext& ctx) {
     ctx.out << value;
 }
 
-void PrintString(const std::string& value, std::ostream& out) {
+}  // namespace
+
+void PrintString(std::string_view value, std::ostream& out) {
     out.put('"');
-    for (const char c : value) {
-        switch (c) {
+    const char* run = value.data();
+    const char* end = value.data() + value.size();
+    // Символы без экранирования выводятся одним куском
+    for (const char* pos; (pos = FindAnyOf<'\r', '\n', '\t', '"', '\\'>(run, end)) != end; run = pos + 1) {
+        std::string_view escaped;
+        switch (*pos) {
             case '\r':
-                out << "\\r"sv;
+                escaped = "\\r"sv;
                 break;
             case '\n':
-                out << "\\n"sv;
+                escaped = "\\n"sv;
                 break;
             case '\t':
-                out << "\\t"sv;
+                escaped = "\\t"sv;
                 break;
             case '"':
                 // Символы " и \ выводятся как \" или \\, соответственно
-                [[fallthrough]];
+                escaped = "\\\""sv;
+                break;
             case '\\':
-                out.put('\\');
-                [[fallthrough]];
-            default:
-                out.put(c);
+                escaped = "\\\\"sv;
                 break;
         }
+        out.write(run, pos - run);
+        out.write(escaped.data(), escaped.size());
     }
+    out.write(run, end - run);
     out.put('"');
 }
 
+namespace {
+
 template <>
 void PrintValue<std::string>(const std::string& value, const PrintContext& ctx) {
     PrintString(value, ctx.out);
@@ -294,19 +640,21 @@ void PrintValue<bool>(const bool& value, const PrintContext& ctx) {
 template <>
 void PrintValue<Array>(const Array& nodes, const PrintContext& ctx) {
     std::ostream& out = ctx.out;
-    out << "[\n"sv;
+    out.put('[');
+    ctx.PrintNewLine();
     bool first = true;
     auto inner_ctx = ctx.Indented();
     for (const Node& node : nodes) {
         if (first) {
             first = false;
         } else {
-            out << ",\n"sv;
+            out.put(',');
+            ctx.PrintNewLine();
         }
         inner_ctx.PrintIndent();
         PrintNode(node, inner_ctx);
     }
-    out.put('\n');
+    ctx.PrintNewLine();
     ctx.PrintIndent();
     out.put(']');
 }
@@ -314,21 +662,23 @@ void PrintValue<Array>(const Array& nodes, const PrintContext& ctx) {
 template <>
 void PrintValue<Dict>(const Dict& nodes, const PrintContext& ctx) {
     std::ostream& out = ctx.out;
-    out << "{\n"sv;
+    out.put('{');
+    ctx.PrintNewLine();
     bool first = true;
     auto inner_ctx = ctx.Indented();
     for (const auto& [key, node] : nodes) {
         if (first) {
             first = false;
         } else {
-            out << ",\n"sv;
+            out.put(',');
+            ctx.PrintNewLine();
         }
         inner_ctx.PrintIndent();
         PrintString(key, ctx.out);
-        out << ": "sv;
+        out << (ctx.mode == PrintMode::PRETTY ? ": "sv : ":"sv);
         PrintNode(node, inner_ctx);
     }
-    out.put('\n');
+    ctx.PrintNewLine();
     ctx.PrintIndent();
     out.put('}');
 }
@@ -343,12 +693,73 @@ void PrintNode(const Node& node, const PrintContext& ctx) {
 
 }  // namespace
 
+memory::Usage Document::GetMemoryUsage() const {
+    return json::GetMemoryUsage(root_);
+}
+
+Document Load(std::string_view input) {
+    return Document{Parser(input).LoadNode()};
+}
+
+void Parse(std::string_view input, Handler& handler) {
+    Parser(input).ParseNode(handler);
+}
+
+std::vector<std::string> LoadRootKeys(std::string_view input) {
+    std::vector<std::string> keys;
+    for (auto& section : SplitRoot(input)) {
+        keys.push_back(std::move(section.first));
+    }
+    return keys;
+}
+
+RootSections SplitRoot(std::string_view input) {
+    return Parser(input).SplitRoot();
+}
+
+std::vector<std::string_view> SplitArray(std::string_view input) {
+    return Parser(input).SplitArray();
+}
+
+std::string ReadAll(std::istream& input) {
+    std::string buffer;
+    char chunk[1 << 16];
+    while (input.read(chunk, sizeof(chunk)) || input.gcount() > 0) {
+        buffer.append(chunk, static_cast<size_t>(input.gcount()));
+    }
+    return buffer;
+}
+
 Document Load(std::istream& input) {
-    return Document{LoadNode(input)};
+    const std::string buffer = ReadAll(input);
+    return Load(std::string_view(buffer));
+}
+
+void Print(const Document& doc, std::ostream& output, PrintMode mode) {
+    PrintNode(doc.GetRoot(), PrintContext{output, 4, 0, mode});
 }
 
-void Print(const Document& doc, std::ostream& output) {
-    PrintNode(doc.GetRoot(), PrintContext{output});
+void Print(const Node& node, std::ostream& output, int indent, PrintMode mode) {
+    PrintNode(node, PrintContext{output, 4, indent, mode});
+}
+
+memory::Usage GetMemoryUsage(const Node& node) {
+    memory::Usage usage{0, 1};
+    if (node.IsArray()) {
+        usage.bytes += memory::VectorBytes(node.AsArray());
+        for (const Node& child : node.AsArray()) {
+            usage += GetMemoryUsage(child);
+        }
+    } else if (node.IsDict()) {
+        usage.bytes += memory::TreeBytes(node.AsDict());
+        for (const auto& [key, child] : node.AsDict()) {
+            usage.bytes += memory::StringBytes(key);
+            usage += GetMemoryUsage(child);
+        }
+    } else if (node.IsString()) {
+        usage.bytes += memory::StringBytes(node.AsString());
+    }
+    return usage;
 }
 
 }  // namespace json
\ No newline at end of file
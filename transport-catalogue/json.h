@@ -1,8 +1,12 @@
 #pragma once
 
+#include "memory_usage.h"
+
 #include <iostream>
 #include <map>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -77,6 +81,14 @@ public:
 
         return std::get<Array>(*this);
     }
+    Array& AsArray() {
+        using namespace std::literals;
+        if (!IsArray()) {
+            throw std::logic_error("Not an array"s);
+        }
+
+        return std::get<Array>(*this);
+    }
 
     bool IsString() const {
         return std::holds_alternative<std::string>(*this);
@@ -89,6 +101,14 @@ public:
 
         return std::get<std::string>(*this);
     }
+    std::string& AsString() {
+        using namespace std::literals;
+        if (!IsString()) {
+            throw std::logic_error("Not a string"s);
+        }
+
+        return std::get<std::string>(*this);
+    }
 
     bool IsDict() const {
         return std::holds_alternative<Dict>(*this);
@@ -101,6 +121,14 @@ public:
 
         return std::get<Dict>(*this);
     }
+    Dict& AsDict() {
+        using namespace std::literals;
+        if (!IsDict()) {
+            throw std::logic_error("Not a dict"s);
+        }
+
+        return std::get<Dict>(*this);
+    }
 
     bool operator==(const Node& rhs) const {
         return GetValue() == rhs.GetValue();
@@ -127,6 +155,13 @@ public:
     const Node& GetRoot() const {
         return root_;
     }
+    // Позволяет забирать части документа при загрузке
+    Node& GetRoot() {
+        return root_;
+    }
+
+    // count — число узлов документа
+    memory::Usage GetMemoryUsage() const;
 
 private:
     Node root_;
@@ -140,8 +175,65 @@ inline bool operator!=(const Document& lhs, const Document& rhs) {
     return !(lhs == rhs);
 }
 
+// Получатель событий потокового разбора. События приходят в том же порядке,
+// в каком значение строилось бы через json::Builder.
+// Ключи и строки передаются без копирования: строка без экранирования указывает
+// в разбираемый текст, остальные — во временный буфер, действительный до следующего события.
+class Handler {
+public:
+    virtual void StartDict() = 0;
+    virtual void Key(std::string_view key) = 0;
+    virtual void EndDict() = 0;
+    virtual void StartArray() = 0;
+    virtual void EndArray() = 0;
+    virtual void String(std::string_view value) = 0;
+    // null, bool, int или double
+    virtual void Value(Node::Value value) = 0;
+
+protected:
+    ~Handler() = default;
+};
+
+// Разбирает текст, сообщая обработчику о каждом значении. Документ целиком не строится.
+void Parse(std::string_view input, Handler& handler);
+
+// Ключи корневого словаря. Значения пропускаются без разбора.
+std::vector<std::string> LoadRootKeys(std::string_view input);
+
+// Ключи корневого словаря и тексты их значений в порядке следования
+using RootSections = std::vector<std::pair<std::string, std::string_view>>;
+
+// Быстрый просмотр структуры без разбора значений: учитываются только кавычки и скобки.
+// Тексты ссылаются на input и разбираются потом по отдельности, например параллельно.
+RootSections SplitRoot(std::string_view input);
+
+// Тексты элементов массива, которым начинается input
+std::vector<std::string_view> SplitArray(std::string_view input);
+
+// Считывает поток до конца крупными блоками
+std::string ReadAll(std::istream& input);
+
+// Разбирает текст, целиком находящийся в памяти: прочитанный файл или отображённый в память
+Document Load(std::string_view input);
+
+// Считывает поток до конца и разбирает прочитанное
 Document Load(std::istream& input);
 
-void Print(const Document& doc, std::ostream& output);
+// PRETTY — с переводами строк и отступами в 4 пробела, COMPACT — без пробельных символов
+enum class PrintMode {
+    PRETTY,
+    COMPACT,
+};
+
+void Print(const Document& doc, std::ostream& output, PrintMode mode = PrintMode::PRETTY);
+
+// Печатает узел так, как он выглядит внутри документа с отступом indent
+void Print(const Node& node, std::ostream& output, int indent, PrintMode mode = PrintMode::PRETTY);
+
+// Строка в кавычках с экранированием
+void PrintString(std::string_view value, std::ostream& output);
+
+// Память узла и всех вложенных в него узлов
+memory::Usage GetMemoryUsage(const Node& node);
 
 }  // namespace json
\ No newline at end of file
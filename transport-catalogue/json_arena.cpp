@@ -0,0 +1,198 @@
+#include "json_arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <variant>
+
+namespace json::arena {
+
+using namespace std::literals;
+
+void* Arena::AllocateBytes(size_t size, size_t alignment) {
+    if (size == 0) {
+        return nullptr;
+    }
+    size_t padding = (alignment - reinterpret_cast<std::uintptr_t>(pos_) % alignment) % alignment;
+    if (pos_ == nullptr || padding + size > left_) {
+        // Начало блока выровнено для любого типа; крупный объект получает отдельный блок
+        const size_t block_size = std::max(BLOCK_SIZE, size);
+        blocks_.push_back(std::make_unique<char[]>(block_size));
+        if (blocks_.size() == 1) {
+            first_block_size_ = block_size;
+        }
+        allocated_ += block_size;
+        pos_ = blocks_.back().get();
+        left_ = block_size;
+        padding = 0;
+    }
+    void* result = pos_ + padding;
+    pos_ += padding + size;
+    left_ -= padding + size;
+    return result;
+}
+
+std::string_view Arena::CopyString(std::string_view str) {
+    char* data = Allocate<char>(str.size());
+    if (!str.empty()) {
+        std::memcpy(data, str.data(), str.size());
+    }
+    return {data, str.size()};
+}
+
+void Arena::Clear() {
+    if (blocks_.empty()) {
+        return;
+    }
+    blocks_.resize(1);
+    allocated_ = first_block_size_;
+    pos_ = blocks_.front().get();
+    left_ = first_block_size_;
+}
+
+memory::Usage Arena::GetMemoryUsage() const {
+    return {allocated_ + memory::VectorBytes(blocks_), blocks_.size()};
+}
+
+const Member* Dict::find(std::string_view key) const {
+    auto it = std::lower_bound(begin(), end(), key, [](const Member& member, std::string_view key) {
+        return member.key < key;
+    });
+    return it != end() && it->key == key ? it : end();
+}
+
+size_t Dict::count(std::string_view key) const {
+    return find(key) != end() ? 1 : 0;
+}
+
+const Node& Dict::at(std::string_view key) const {
+    const Member* member = find(key);
+    if (member == end()) {
+        throw std::out_of_range("Key not found: "s + std::string(key));
+    }
+    return member->value;
+}
+
+bool IsWithin(std::string_view part, std::string_view text) {
+    const std::less_equal<const char*> not_after;
+    return !text.empty() && not_after(text.data(), part.data())
+           && not_after(part.data() + part.size(), text.data() + text.size());
+}
+
+DocumentBuilder::DocumentBuilder(Arena& arena, std::string_view source)
+    : arena_(arena)
+    , source_(source) {
+}
+
+Node DocumentBuilder::Build() {
+    if (values_.size() != 1 || !frames_.empty()) {
+        throw ParsingError("Incomplete document"s);
+    }
+    const Node root = values_.back();
+    values_.clear();
+    return root;
+}
+
+void DocumentBuilder::StartDict() {
+    frames_.push_back({values_.size(), keys_.size()});
+}
+
+void DocumentBuilder::Key(std::string_view key) {
+    keys_.push_back(Store(key));
+}
+
+void DocumentBuilder::EndDict() {
+    const Frame frame = frames_.back();
+    frames_.pop_back();
+
+    const size_t size = values_.size() - frame.values_begin;
+    Member* members = arena_.Allocate<Member>(size);
+    for (size_t index = 0; index < size; ++index) {
+        new (members + index) Member{keys_[frame.keys_begin + index], values_[frame.values_begin + index]};
+    }
+    std::sort(members, members + size, [](const Member& lhs, const Member& rhs) {
+        return lhs.key < rhs.key;
+    });
+    auto duplicate = std::adjacent_find(members, members + size, [](const Member& lhs, const Member& rhs) {
+        return lhs.key == rhs.key;
+    });
+    if (duplicate != members + size) {
+        throw ParsingError("Duplicate key '"s + std::string(duplicate->key) + "' have been found");
+    }
+
+    keys_.resize(frame.keys_begin);
+    values_.resize(frame.values_begin);
+    Push(Dict{members, size});
+}
+
+void DocumentBuilder::StartArray() {
+    frames_.push_back({values_.size(), keys_.size()});
+}
+
+void DocumentBuilder::EndArray() {
+    const Frame frame = frames_.back();
+    frames_.pop_back();
+
+    const size_t size = values_.size() - frame.values_begin;
+    Node* items = arena_.Allocate<Node>(size);
+    std::uninitialized_copy(values_.begin() + frame.values_begin, values_.end(), items);
+
+    values_.resize(frame.values_begin);
+    Push(Array{items, size});
+}
+
+void DocumentBuilder::String(std::string_view value) {
+    Push(Store(value));
+}
+
+void DocumentBuilder::Value(json::Node::Value value) {
+    std::visit([this](auto& scalar) {
+        using T = std::decay_t<decltype(scalar)>;
+        if constexpr (std::is_same_v<T, std::string>) {
+            Push(arena_.CopyString(scalar));
+        } else if constexpr (std::is_same_v<T, json::Array> || std::is_same_v<T, json::Dict>) {
+            throw ParsingError("Unexpected container value"s);
+        } else {
+            Push(scalar);
+        }
+    }, value);
+}
+
+void DocumentBuilder::Push(Node node) {
+    values_.push_back(node);
+    ++node_count_;
+}
+
+// Строка внутри исходного текста не копируется
+std::string_view DocumentBuilder::Store(std::string_view str) {
+    return IsWithin(str, source_) ? str : arena_.CopyString(str);
+}
+
+memory::Usage Document::GetMemoryUsage() const {
+    return {arena_.GetMemoryUsage().bytes, node_count_};
+}
+
+Document Load(std::string_view input) {
+    Document document;
+    DocumentBuilder builder(document.arena_);
+    json::Parse(input, builder);
+    document.root_ = builder.Build();
+    document.node_count_ = builder.GetNodeCount();
+    return document;
+}
+
+Document LoadBorrowed(std::string_view input) {
+    Document document;
+    DocumentBuilder builder(document.arena_, input);
+    json::Parse(input, builder);
+    document.root_ = builder.Build();
+    document.node_count_ = builder.GetNodeCount();
+    return document;
+}
+
+}  // namespace json::arena
@@ -0,0 +1,288 @@
+#pragma once
+
+#include "json.h"
+#include "memory_usage.h"
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+// Документ JSON, все узлы и строки которого лежат в общей области памяти документа.
+// Память выделяется крупными блоками и освобождается целиком вместе с документом.
+// Словарь хранится массивом пар, упорядоченным по ключу, массив — массивом узлов.
+namespace json::arena {
+
+// Область памяти, из которой объекты выделяются подряд. Объекты не разрушаются,
+// поэтому в ней хранятся только тривиально разрушаемые типы.
+class Arena {
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    Arena(Arena&&) = default;
+    Arena& operator=(Arena&&) = default;
+
+    template <typename T>
+    T* Allocate(size_t count) {
+        return static_cast<T*>(AllocateBytes(count * sizeof(T), alignof(T)));
+    }
+
+    std::string_view CopyString(std::string_view str);
+
+    // Освобождает всё выделенное, кроме первого блока, который используется повторно
+    void Clear();
+
+    // count — число блоков
+    memory::Usage GetMemoryUsage() const;
+
+private:
+    void* AllocateBytes(size_t size, size_t alignment);
+
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    size_t first_block_size_ = 0;
+    size_t allocated_ = 0;
+    char* pos_ = nullptr;
+    size_t left_ = 0;
+};
+
+// Непрерывный участок памяти документа
+template <typename T>
+class Span {
+public:
+    Span() = default;
+    Span(const T* data, size_t size)
+        : data_(data)
+        , size_(size) {
+    }
+
+    const T* begin() const {
+        return data_;
+    }
+    const T* end() const {
+        return data_ + size_;
+    }
+    size_t size() const {
+        return size_;
+    }
+    bool empty() const {
+        return size_ == 0;
+    }
+    const T& operator[](size_t index) const {
+        return data_[index];
+    }
+    const T& at(size_t index) const {
+        using namespace std::literals;
+        if (index >= size_) {
+            throw std::out_of_range("Index out of range"s);
+        }
+        return data_[index];
+    }
+
+private:
+    const T* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+class Node;
+struct Member;
+
+using Array = Span<Node>;
+
+// Пары упорядочены по ключу, поиск двоичный
+class Dict : public Span<Member> {
+public:
+    using Span::Span;
+
+    const Member* find(std::string_view key) const;
+    size_t count(std::string_view key) const;
+    const Node& at(std::string_view key) const;
+};
+
+class Node final {
+public:
+    enum class Type : unsigned char { NULL_VALUE, BOOL, INT, DOUBLE, STRING, ARRAY, DICT };
+
+    Node() = default;
+    Node(std::nullptr_t) {
+    }
+    Node(bool value)
+        : type_(Type::BOOL) {
+        bool_ = value;
+    }
+    Node(int value)
+        : type_(Type::INT) {
+        int_ = value;
+    }
+    Node(double value)
+        : type_(Type::DOUBLE) {
+        double_ = value;
+    }
+    // Строка должна лежать в памяти документа
+    Node(std::string_view value)
+        : type_(Type::STRING) {
+        items_ = value.data();
+        size_ = value.size();
+    }
+    Node(Array value)
+        : type_(Type::ARRAY) {
+        items_ = value.begin();
+        size_ = value.size();
+    }
+    Node(Dict value)
+        : type_(Type::DICT) {
+        items_ = value.begin();
+        size_ = value.size();
+    }
+
+    Type GetType() const {
+        return type_;
+    }
+
+    bool IsNull() const {
+        return type_ == Type::NULL_VALUE;
+    }
+    bool IsBool() const {
+        return type_ == Type::BOOL;
+    }
+    bool IsInt() const {
+        return type_ == Type::INT;
+    }
+    bool IsPureDouble() const {
+        return type_ == Type::DOUBLE;
+    }
+    bool IsDouble() const {
+        return IsInt() || IsPureDouble();
+    }
+    bool IsString() const {
+        return type_ == Type::STRING;
+    }
+    bool IsArray() const {
+        return type_ == Type::ARRAY;
+    }
+    bool IsDict() const {
+        return type_ == Type::DICT;
+    }
+
+    bool AsBool() const {
+        Check(IsBool(), "Not a bool");
+        return bool_;
+    }
+    int AsInt() const {
+        Check(IsInt(), "Not an int");
+        return int_;
+    }
+    double AsDouble() const {
+        Check(IsDouble(), "Not a double");
+        return IsPureDouble() ? double_ : int_;
+    }
+    std::string_view AsString() const {
+        Check(IsString(), "Not a string");
+        return {static_cast<const char*>(items_), size_};
+    }
+    Array AsArray() const {
+        Check(IsArray(), "Not an array");
+        return {static_cast<const Node*>(items_), size_};
+    }
+    Dict AsDict() const;
+
+private:
+    static void Check(bool condition, const char* message) {
+        if (!condition) {
+            throw std::logic_error(message);
+        }
+    }
+
+    Type type_ = Type::NULL_VALUE;
+    union {
+        bool bool_;
+        int int_;
+        double double_;
+        const void* items_ = nullptr;
+    };
+    size_t size_ = 0;
+};
+
+struct Member {
+    std::string_view key;
+    Node value;
+};
+
+inline Dict Node::AsDict() const {
+    Check(IsDict(), "Not a dict");
+    return {static_cast<const Member*>(items_), size_};
+}
+
+// Лежит ли part целиком внутри text
+bool IsWithin(std::string_view part, std::string_view text);
+
+// Строит документ по событиям разбора. Готовые значения и ключи копятся в стеках,
+// при закрытии массива или словаря его элементы переносятся в память документа одним куском.
+// Если задан исходный текст, строки без экранирования не копируются, а ссылаются на него.
+// После Build() построитель готов к следующему документу в той же памяти.
+class DocumentBuilder final : public Handler {
+public:
+    explicit DocumentBuilder(Arena& arena, std::string_view source = {});
+
+    Node Build();
+
+    size_t GetNodeCount() const {
+        return node_count_;
+    }
+
+    void StartDict() override;
+    void Key(std::string_view key) override;
+    void EndDict() override;
+    void StartArray() override;
+    void EndArray() override;
+    void String(std::string_view value) override;
+    void Value(json::Node::Value value) override;
+
+private:
+    struct Frame {
+        size_t values_begin;
+        size_t keys_begin;
+    };
+
+    void Push(Node node);
+    std::string_view Store(std::string_view str);
+
+    Arena& arena_;
+    std::string_view source_;
+    std::vector<Node> values_;
+    std::vector<std::string_view> keys_;
+    std::vector<Frame> frames_;
+    size_t node_count_ = 0;
+};
+
+class Document {
+public:
+    Document() = default;
+
+    const Node& GetRoot() const {
+        return root_;
+    }
+
+    // count — число узлов документа
+    memory::Usage GetMemoryUsage() const;
+
+private:
+    friend Document Load(std::string_view input);
+    friend Document LoadBorrowed(std::string_view input);
+
+    Arena arena_;
+    Node root_;
+    size_t node_count_ = 0;
+};
+
+// Разбирает текст тем же разборщиком, что и json::Load, но строит документ в общей памяти
+Document Load(std::string_view input);
+
+// То же без копирования строк: строки без экранирования ссылаются на input,
+// который должен оставаться в памяти, пока используется документ
+Document LoadBorrowed(std::string_view input);
+
+}  // namespace json::arena
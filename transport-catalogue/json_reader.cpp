@@ -1,7 +1,16 @@
 #include "json_reader.h"
 #include "json_builder.h"
+#include "json_schema.h"
+#include "json_writer.h"
 
 #include <algorithm>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <optional>
+#include <set>
 #include <sstream>
 
 using namespace reader;
@@ -9,118 +18,719 @@ using namespace std;
 
 using namespace literals;
 
+namespace {
+
+// Собирает документ из всех разделов, кроме base_requests. Запросы из base_requests
+// собираются по одному в переиспользуемой памяти и сразу передаются в on_request;
+// их строки без экранирования ссылаются на входной текст.
+class RequestsStreamer final : public json::Handler {
+public:
+    RequestsStreamer(std::string_view input, std::function<void(const json::arena::Node&)> on_request)
+    : request_builder_(arena_, input)
+    , on_request_(std::move(on_request)){
+    }
+
+    json::Document Build(){
+        return json::Document(std::move(root_));
+    }
+
+    void StartDict() override {
+        if (depth_ == 0){
+            ++depth_;
+            return;
+        }
+        if (is_streaming_){
+            ++depth_;
+            request_builder_.StartDict();
+            return;
+        }
+        StartNested();
+        builder_->StartDict();
+    }
+
+    void Key(std::string_view key) override {
+        if (depth_ == 1){
+            key_ = key;
+            return;
+        }
+        if (is_streaming_){
+            request_builder_.Key(key);
+            return;
+        }
+        builder_->Key(std::string(key));
+    }
+
+    void EndDict() override {
+        if (depth_ == 1){
+            --depth_;
+            return;
+        }
+        if (is_streaming_){
+            request_builder_.EndDict();
+            --depth_;
+            FinishRequest();
+            return;
+        }
+        builder_->EndDict();
+        EndNested();
+    }
+
+    void StartArray() override {
+        if (depth_ == 0){
+            throw json::ParsingError("Root must be a dict"s);
+        }
+        if (depth_ == 1 && key_ == "base_requests"sv){
+            is_streaming_ = true;
+            ++depth_;
+            return;
+        }
+        if (is_streaming_){
+            ++depth_;
+            request_builder_.StartArray();
+            return;
+        }
+        StartNested();
+        builder_->StartArray();
+    }
+
+    void EndArray() override {
+        if (depth_ == 2 && is_streaming_){
+            is_streaming_ = false;
+            --depth_;
+            return;
+        }
+        if (is_streaming_){
+            request_builder_.EndArray();
+            --depth_;
+            FinishRequest();
+            return;
+        }
+        builder_->EndArray();
+        EndNested();
+    }
+
+    void String(std::string_view value) override {
+        if (is_streaming_){
+            request_builder_.String(value);
+            FinishRequest();
+            return;
+        }
+        Value(std::string(value));
+    }
+
+    void Value(json::Node::Value value) override {
+        if (depth_ == 0){
+            throw json::ParsingError("Root must be a dict"s);
+        }
+        if (is_streaming_){
+            request_builder_.Value(std::move(value));
+            FinishRequest();
+        } else if (depth_ == 1){
+            root_[key_] = std::move(value);
+        } else {
+            builder_->Value(std::move(value));
+        }
+    }
+
+private:
+    void StartNested(){
+        if (depth_ == 1){
+            builder_.emplace();
+        }
+        ++depth_;
+    }
+
+    void EndNested(){
+        --depth_;
+        if (depth_ != 1){
+            return;
+        }
+        root_[key_] = builder_->Build();
+        builder_.reset();
+    }
+
+    // Запрос на заполнение передаётся, как только собран целиком, и его память переиспользуется
+    void FinishRequest(){
+        if (depth_ != 2){
+            return;
+        }
+        on_request_(request_builder_.Build());
+        arena_.Clear();
+    }
+
+    json::arena::Arena arena_;
+    json::arena::DocumentBuilder request_builder_;
+    std::function<void(const json::arena::Node&)> on_request_;
+    json::Dict root_;
+    std::string key_;
+    std::optional<json::Builder> builder_;
+    size_t depth_ = 0;
+    bool is_streaming_ = false;
+};
+
+// "output_settings": {"compact": true} — ответы без пробельных символов
+json::PrintMode GetPrintMode(const json::Dict& root){
+    if (!root.count("output_settings"s)){
+        return json::PrintMode::PRETTY;
+    }
+    const json::Dict& settings = root.at("output_settings"s).AsDict();
+    return settings.count("compact"s) && settings.at("compact"s).AsBool()
+            ? json::PrintMode::COMPACT
+            : json::PrintMode::PRETTY;
+}
+
+// Скорости делят расстояния при расчёте времени, поэтому нулевые и отрицательные не принимаются
+void CheckRouteSettings(const RouteSettings& settings){
+    using json::schema::SchemaError;
+    if (!(settings.wait_time >= 0)){
+        throw SchemaError("bus_wait_time"s, "expected a non-negative number"s);
+    }
+    if (!(settings.velocity > 0)){
+        throw SchemaError("bus_velocity"s, "expected a positive number"s);
+    }
+    if (!(settings.pedestrian_velocity > 0)){
+        throw SchemaError("pedestrian_velocity"s, "expected a positive number"s);
+    }
+    if (!(settings.walk_radius >= 0)){
+        throw SchemaError("walk_radius"s, "expected a non-negative number"s);
+    }
+}
+
+// Запрос base_requests с номером index, который попадёт в сообщение об ошибке
+template <typename Node>
+requests::BaseRequest DecodeBaseRequest(const Node& request, size_t index){
+    try {
+        if (json::schema::GetTag(request, "type"sv) == "Bus"sv){
+            return json::schema::Decode<requests::BusRequest>(request);
+        }
+        return json::schema::Decode<requests::StopRequest>(request);
+    } catch (const json::schema::SchemaError& error){
+        throw error.InItem(index).InKey("base_requests"sv);
+    }
+}
+
+// Меньше элементов на поток не даётся: запуск потока дороже их разбора
+constexpr size_t MIN_CHUNK_SIZE = 256;
+
+// Делит элементы [0, size) не больше чем на threads частей и запускает по потоку на часть.
+// process(begin, end) обрабатывает элементы [begin, end). Вложенных запусков нет,
+// поэтому одновременно работает не больше threads потоков.
+template <typename Process>
+auto StartChunks(size_t size, size_t threads, Process process){
+    using Result = decltype(process(size_t{}, size_t{}));
+    const size_t chunk_count = std::max<size_t>(1, std::min(threads, size / MIN_CHUNK_SIZE));
+    vector<future<Result>> futures;
+    futures.reserve(chunk_count);
+    for (size_t chunk = 0; chunk < chunk_count; ++chunk){
+        futures.push_back(async(launch::async, process, size * chunk / chunk_count, size * (chunk + 1) / chunk_count));
+    }
+    return futures;
+}
+
+// Результаты частей по порядку
+template <typename Result>
+vector<Result> GetResults(vector<future<Result>>& futures){
+    vector<Result> results;
+    results.reserve(futures.size());
+    for (auto& result : futures){
+        results.push_back(result.get());
+    }
+    return results;
+}
+
+// Запросы base_requests одной части входа. Строки ссылаются на вход,
+// а экранированные — на копии в strings.
+struct BaseRequestsChunk {
+    json::arena::Arena strings;
+    vector<requests::BaseRequest> requests;
+};
+
+BaseRequestsChunk DecodeBaseRequests(std::string_view input, const vector<std::string_view>& items
+                                     , size_t begin, size_t end){
+    BaseRequestsChunk chunk;
+    chunk.requests.reserve(end - begin);
+    // Узлы запроса нужны только до его разбора по схеме
+    json::arena::Arena nodes;
+    json::arena::DocumentBuilder builder(nodes, input);
+    auto keep = [&input, &chunk](std::string_view& str){
+        if (!json::arena::IsWithin(str, input)){
+            str = chunk.strings.CopyString(str);
+        }
+    };
+    for (size_t index = begin; index < end; ++index){
+        json::Parse(items[index], builder);
+        requests::BaseRequest request = DecodeBaseRequest(builder.Build(), index);
+        if (auto* stop = get_if<requests::StopRequest>(&request)){
+            keep(stop->name);
+            for (auto& [to, distance] : stop->road_distances){
+                keep(to);
+            }
+        } else {
+            auto& bus = get<requests::BusRequest>(request);
+            keep(bus.name);
+            for (auto& stop : bus.stops){
+                keep(stop);
+            }
+        }
+        chunk.requests.push_back(std::move(request));
+        nodes.Clear();
+    }
+    return chunk;
+}
+
+// Запрос delta_requests с номером для сообщений об ошибках
+template <typename Request>
+struct DeltaItem {
+    size_t index;
+    Request request;
+};
+
+// Запросы delta_requests, разложенные по этапам применения
+struct DeltaBatch {
+    vector<DeltaItem<requests::StopRequest>> stops;
+    vector<DeltaItem<requests::DistanceRequest>> distances;
+    vector<DeltaItem<requests::RemoveRequest>> removed_buses;
+    vector<DeltaItem<requests::BusRequest>> buses;
+    vector<DeltaItem<requests::RemoveDistanceRequest>> removed_distances;
+    vector<DeltaItem<requests::RemoveRequest>> removed_stops;
+};
+
+[[noreturn]] void ThrowDeltaError(size_t index, const json::schema::SchemaError& error){
+    throw error.InItem(index).InKey("delta_requests"sv);
+}
+
+DeltaBatch DecodeDeltaRequests(const json::Node& delta){
+    if (!delta.IsArray()){
+        throw json::schema::SchemaError("delta_requests"s, "expected an array"s);
+    }
+    DeltaBatch batch;
+    const json::Array& items = delta.AsArray();
+    for (size_t index = 0; index < items.size(); ++index){
+        try {
+            const std::string_view type = json::schema::GetTag(items[index], "type"sv);
+            const bool is_deletion = json::schema::Decode<requests::DeletionMark>(items[index]).is_deletion;
+            if (type == "Stop"sv){
+                if (is_deletion){
+                    batch.removed_stops.push_back({index, json::schema::Decode<requests::RemoveRequest>(items[index])});
+                } else {
+                    batch.stops.push_back({index, json::schema::Decode<requests::StopRequest>(items[index])});
+                }
+            } else if (type == "Bus"sv){
+                if (is_deletion){
+                    batch.removed_buses.push_back({index, json::schema::Decode<requests::RemoveRequest>(items[index])});
+                } else {
+                    batch.buses.push_back({index, json::schema::Decode<requests::BusRequest>(items[index])});
+                }
+            } else if (type == "Distance"sv){
+                if (is_deletion){
+                    batch.removed_distances.push_back({index, json::schema::Decode<requests::RemoveDistanceRequest>(items[index])});
+                } else {
+                    batch.distances.push_back({index, json::schema::Decode<requests::DistanceRequest>(items[index])});
+                }
+            } else {
+                throw json::schema::SchemaError("type"s, "unknown delta type "s + string(type));
+            }
+        } catch (const json::schema::SchemaError& error){
+            ThrowDeltaError(index, error);
+        }
+    }
+    return batch;
+}
+
+std::string_view StopName(StopPtr stop){
+    return stop->name;
+}
+
+std::string_view StopName(std::string_view name){
+    return name;
+}
+
+// Проходит ли путь по участку from -> to
+template <typename Route>
+bool HasSegment(const Route& route, std::string_view from, std::string_view to){
+    for (size_t index = 1; index < route.size(); ++index){
+        if (StopName(route[index - 1]) == from && StopName(route[index]) == to){
+            return true;
+        }
+    }
+    return false;
+}
+
+RoutePath<vector<std::string_view>::const_iterator> GetRoute(const requests::BusRequest& bus){
+    return {bus.stops.begin(), bus.stops.end(), bus.is_roundtrip};
+}
+
+// Проверяет пачку целиком по состоянию справочника после её применения.
+// После проверки этапы применения не бросают исключений, и справочник
+// не остаётся изменённым наполовину.
+class DeltaValidator {
+public:
+    DeltaValidator(const TransportCatalogue& db, const DeltaBatch& batch)
+    : db_(db)
+    , batch_(batch){
+        for (const auto& [index, stop] : batch_.stops){
+            new_stops_.insert(stop.name);
+            for (const auto& [to, distance] : stop.road_distances){
+                new_distances_.insert({stop.name, to});
+                new_distances_.insert({to, stop.name});
+            }
+        }
+        for (const auto& [index, distance] : batch_.distances){
+            new_distances_.insert({distance.from, distance.to});
+            new_distances_.insert({distance.to, distance.from});
+        }
+        for (const auto& [index, bus] : batch_.removed_buses){
+            removed_buses_.insert(bus.name);
+        }
+        // Из повторов одного автобуса действует последний
+        for (const auto& [index, bus] : batch_.buses){
+            new_buses_[bus.name] = &bus;
+        }
+    }
+
+    void Validate() const {
+        for (const auto& [index, stop] : batch_.stops){
+            for (const auto& [to, distance] : stop.road_distances){
+                if (!HasStop(to)){
+                    ThrowDeltaError(index, json::schema::SchemaError(string(to), "unknown stop"s).InKey("road_distances"sv));
+                }
+            }
+        }
+        for (const auto& [index, distance] : batch_.distances){
+            if (!HasStop(distance.from)){
+                ThrowDeltaError(index, json::schema::SchemaError("from"s, "unknown stop "s + string(distance.from)));
+            }
+            if (!HasStop(distance.to)){
+                ThrowDeltaError(index, json::schema::SchemaError("to"s, "unknown stop "s + string(distance.to)));
+            }
+        }
+        for (const auto& [index, bus] : batch_.buses){
+            for (size_t stop = 0; stop < bus.stops.size(); ++stop){
+                if (!HasStop(bus.stops[stop])){
+                    ThrowDeltaError(index, json::schema::SchemaError("["s + to_string(stop) + "]"s, "unknown stop "s + string(bus.stops[stop]))
+                                           .InKey("stops"sv));
+                }
+            }
+            const auto route = GetRoute(bus);
+            for (size_t stop = 1; stop < route.size(); ++stop){
+                if (!HasDistance(route[stop - 1], route[stop])){
+                    ThrowDeltaError(index, json::schema::SchemaError("stops"s, "no road distance from "s + string(route[stop - 1])
+                                                                     + " to "s + string(route[stop])));
+                }
+            }
+        }
+        for (const auto& [index, distance] : batch_.removed_distances){
+            if (auto bus = FindBusOnSegment(distance.from, distance.to)){
+                ThrowDeltaError(index, json::schema::SchemaError({}, "distance is used by bus "s + string(*bus)));
+            }
+        }
+        for (const auto& [index, stop] : batch_.removed_stops){
+            if (auto bus = FindBusThrough(stop.name)){
+                ThrowDeltaError(index, json::schema::SchemaError({}, "stop is used by bus "s + string(*bus)));
+            }
+        }
+    }
+
+private:
+    bool HasStop(std::string_view name) const {
+        return db_.GetStop(name) != nullptr || new_stops_.count(name);
+    }
+
+    // Расстояние к моменту добавления автобусов: удаление расстояний идёт позже
+    bool HasDistance(std::string_view from, std::string_view to) const {
+        if (new_distances_.count({from, to})){
+            return true;
+        }
+        StopPtr from_stop = db_.GetStop(from);
+        StopPtr to_stop = db_.GetStop(to);
+        return from_stop && to_stop && db_.HasDistance(from_stop, to_stop);
+    }
+
+    // Маршрут автобуса из справочника остаётся, если пачка его не удаляет и не заменяет
+    bool IsKept(BusPtr bus) const {
+        return !removed_buses_.count(bus->name) && !new_buses_.count(bus->name);
+    }
+
+    // Автобус, который после применения пачки проходит по участку from -> to
+    optional<std::string_view> FindBusOnSegment(std::string_view from, std::string_view to) const {
+        if (const StopInfo* info = db_.GetStopInfo(from)){
+            for (BusPtr bus : info->through_buses){
+                if (IsKept(bus) && HasSegment(bus->GetRoute(), from, to)){
+                    return bus->name;
+                }
+            }
+        }
+        for (const auto& [name, bus] : new_buses_){
+            if (HasSegment(GetRoute(*bus), from, to)){
+                return name;
+            }
+        }
+        return nullopt;
+    }
+
+    // Автобус, который после применения пачки проходит через остановку
+    optional<std::string_view> FindBusThrough(std::string_view stop) const {
+        if (const StopInfo* info = db_.GetStopInfo(stop)){
+            for (BusPtr bus : info->through_buses){
+                if (IsKept(bus)){
+                    return bus->name;
+                }
+            }
+        }
+        for (const auto& [name, bus] : new_buses_){
+            if (find(bus->stops.begin(), bus->stops.end(), stop) != bus->stops.end()){
+                return name;
+            }
+        }
+        return nullopt;
+    }
+
+    const TransportCatalogue& db_;
+    const DeltaBatch& batch_;
+    set<std::string_view> new_stops_;
+    set<pair<std::string_view, std::string_view>> new_distances_;
+    set<std::string_view> removed_buses_;
+    map<std::string_view, const requests::BusRequest*> new_buses_;
+};
+
+}  // namespace
+
+//--------------------- Delta ------------------------
+
+// Изменения применяются по этапам, чтобы ссылки внутри одной пачки не зависели от порядка:
+// остановки, расстояния, удаление автобусов, автобусы, удаление расстояний, удаление остановок
+void reader::ApplyDelta(TransportCatalogue& db, const json::Node& delta_requests){
+    const DeltaBatch batch = DecodeDeltaRequests(delta_requests);
+    DeltaValidator(db, batch).Validate();
+
+    for (const auto& [index, request] : batch.stops){
+        db.UpsertStop(request.name, {request.latitude, request.longitude});
+    }
+    for (const auto& [index, request] : batch.stops){
+        vector<pair<StopPtr, double>> distances;
+        distances.reserve(request.road_distances.size());
+        for (const auto& [to, distance] : request.road_distances){
+            distances.emplace_back(db.GetStop(to), distance);
+        }
+        db.AddDistances(db.GetStop(request.name), distances);
+    }
+    for (const auto& [index, request] : batch.distances){
+        db.AddDistance(db.GetStop(request.from), db.GetStop(request.to), request.distance);
+    }
+    for (const auto& [index, request] : batch.removed_buses){
+        db.RemoveBus(request.name);
+    }
+    for (const auto& [index, request] : batch.buses){
+        vector<StopPtr> route;
+        route.reserve(request.stops.size());
+        for (std::string_view stop : request.stops){
+            route.push_back(db.GetStop(stop));
+        }
+        db.UpsertBus(request.name, std::move(route), request.is_roundtrip);
+    }
+    for (const auto& [index, request] : batch.removed_distances){
+        StopPtr from = db.GetStop(request.from);
+        StopPtr to = db.GetStop(request.to);
+        if (from && to){
+            db.RemoveDistance(from, to);
+        }
+    }
+    for (const auto& [index, request] : batch.removed_stops){
+        db.RemoveStop(request.name);
+    }
+}
+
 //--------------------- JsonReader ------------------------
 
-JsonReader::JsonReader(TransportCatalogue& db, const RequestHandler& handler, istream& in)
-: db_(db)
-, handler_(handler)
-, root_request_(json::Load(in)){
+JsonReader::JsonReader(TransportCatalogue& db, istream& in)
+: JsonReader(db, json::Load(in)){
+}
+
+JsonReader::JsonReader(TransportCatalogue& db, json::Document document)
+: db_(&db)
+, root_request_(std::move(document)){
     FillCatalogue();
     ParseRenderSettings();
+    print_mode_ = GetPrintMode(root_request_.GetRoot().AsDict());
 }
 
-
-void JsonReader::FillCatalogue(){
-    ParseEntryRequests();
-    FillStops();
-    AddDistances();
-    SetRoutingInfo();
-    FillBuses();
-    
-
-    temp_requests_.clear();
-    ParseStatRequests();
+JsonReader::JsonReader(TransportCatalogue& db, std::string_view input, size_t threads, size_t parallel_input_size)
+: db_(&db)
+, root_request_(json::Node{}){
+    if (threads > 1 && input.size() >= parallel_input_size){
+        LoadParallel(input, threads);
+    } else {
+        LoadStreaming(input);
+    }
+    FinishBaseRequests();
+    ParseRenderSettings();
+    print_mode_ = GetPrintMode(root_request_.GetRoot().AsDict());
 }
 
-json::Document JsonReader::MakeOutDocument() const {
-    std::deque<json::Node> for_print;
-    for (const auto& request : temp_requests_){
-        for_print.emplace_back(std::move(MakeStatNode(request)));
+
+void JsonReader::FillCatalogue(){
+    json::Dict& root = root_request_.GetRoot().AsDict();
+    json::Array requests = std::move(root.at("base_requests"s).AsArray());
+    root.erase("base_requests"s);
+    for (size_t index = 0; index < requests.size(); ++index){
+        AddBaseRequest(DecodeBaseRequest(requests[index], index));
     }
-    return json::Document(json::Array{for_print.begin(), for_print.end()});
+    requests = {};
+    FinishBaseRequests();
 }
 
-void JsonReader::PrintStat(std::ostream& out) {
+// Ответы выводятся по мере вычисления, дерево узлов для них не строится
+void JsonReader::PrintStat(const RequestHandler& handler, std::ostream& out) const {
     if (temp_requests_.empty()){
         return;
     }
-    json::Print(MakeOutDocument(), out);
+    json::Writer writer(out, print_mode_);
+    writer.StartArray();
+    for (size_t index = 0; index < temp_requests_.size(); ++index){
+        try {
+            WriteStat(writer, handler, temp_requests_[index]);
+        } catch (const json::schema::SchemaError& error){
+            throw error.InItem(index).InKey("stat_requests"sv);
+        }
+    }
+    writer.EndArray();
     out.flush();
 }
 
-renderer::RenderContext JsonReader::GetRenderContext() const {
-    renderer::RenderContext temp = render_context_;
-    std::unordered_set<StopPtr> used_coords;
-    for (auto bus : render_context_.buses_to_draw){
-        for (auto stop : bus->route){
-            used_coords.emplace(stop);
-        }
-    }
-    for (auto stop : used_coords){
-        temp.all_stops.emplace_back(stop);
-    }
-    std::sort(temp.all_stops.begin(), temp.all_stops.end(), 
-            [](StopPtr lhs, StopPtr rhs){return lhs->name < rhs->name;});
-            
-    return temp;
+renderer::Settings JsonReader::GetRenderSettings() const {
+    return render_settings_;
+}
+
+const json::Node* JsonReader::GetDeltaRequests() const {
+    const json::Dict& root = root_request_.GetRoot().AsDict();
+    auto it = root.find("delta_requests"s);
+    return it == root.end() ? nullptr : &it->second;
 }
 
 // Entry______________________
 
-void JsonReader::ParseEntryRequests(){
-    temp_requests_ = std::move(root_request_.GetRoot().AsDict().at("base_requests"s).AsArray());
-    for (const auto& node : temp_requests_){
-        if (node.AsDict().at("type").AsString()[0] == 'B'){
-            bus_parsed_requests_.emplace_back(&node);
-            continue;
+void JsonReader::AddBaseRequest(const requests::BaseRequest& request){
+    if (const auto* bus = get_if<requests::BusRequest>(&request)){
+        pending_buses_.push_back({string(bus->name), {bus->stops.begin(), bus->stops.end()}, bus->is_roundtrip});
+        return;
+    }
+    const auto& stop_request = get<requests::StopRequest>(request);
+    StopPtr stop = db_->AddStop(stop_request.name, {stop_request.latitude, stop_request.longitude});
+    // Порядок добавления не важен: заданное расстояние всегда заменяет подставленное обратное
+    vector<pair<StopPtr, double>> distances;
+    distances.reserve(stop_request.road_distances.size());
+    for (const auto& [to, distance] : stop_request.road_distances){
+        if (StopPtr to_stop = db_->GetStop(to)){
+            distances.emplace_back(to_stop, distance);
+        } else {
+            pending_distances_.push_back({stop, string(to), distance});
         }
-        stop_parsed_requests_.emplace_back(&node);
     }
+    db_->AddDistances(stop, distances);
+}
+
+void JsonReader::LoadStreaming(std::string_view input){
+    size_t index = 0;
+    RequestsStreamer streamer(input, [this, &index](const json::arena::Node& request){
+        AddBaseRequest(DecodeBaseRequest(request, index++));
+    });
+    json::Parse(input, streamer);
+    root_request_ = streamer.Build();
 }
 
-void JsonReader::FillStops(){
-    for (const auto& request : stop_parsed_requests_){
-        geo::Coordinates coords{request->AsDict().at("latitude"s).AsDouble(), 
-                                request->AsDict().at("longitude"s).AsDouble()};
+// Элементы base_requests разбираются по частям параллельно, затем применяются по порядку.
+// Пока они применяются, в других потоках разбираются stat_requests.
+void JsonReader::LoadParallel(std::string_view input, size_t threads){
+    json::Dict root;
+    vector<std::string_view> base_requests;
+    vector<std::string_view> stat_requests;
+    for (auto& [key, text] : json::SplitRoot(input)){
+        if (key == "base_requests"sv){
+            base_requests = json::SplitArray(text);
+        } else if (key == "stat_requests"sv){
+            stat_requests = json::SplitArray(text);
+        } else {
+            root[key] = std::move(json::Load(text).GetRoot());
+        }
+    }
+
+    auto base_futures = StartChunks(base_requests.size(), threads, [input, &base_requests](size_t begin, size_t end){
+        return DecodeBaseRequests(input, base_requests, begin, end);
+    });
+    auto base_chunks = GetResults(base_futures);
+    // Этот поток занят применением запросов, поэтому stat_requests достаётся на поток меньше
+    auto stat_futures = StartChunks(stat_requests.size(), threads - 1, [&stat_requests](size_t begin, size_t end){
+        json::Array requests;
+        requests.reserve(end - begin);
+        for (size_t index = begin; index < end; ++index){
+            requests.push_back(std::move(json::Load(stat_requests[index]).GetRoot()));
+        }
+        return requests;
+    });
 
-        db_.AddStop(std::move(request->AsDict().at("name"s).AsString())
-                    ,coords);
+    for (auto& chunk : base_chunks){
+        for (const auto& request : chunk.requests){
+            AddBaseRequest(request);
+        }
+        chunk = {};
     }
+    for (auto& chunk : GetResults(stat_futures)){
+        move(chunk.begin(), chunk.end(), back_inserter(temp_requests_));
+    }
+    root_request_ = json::Document(std::move(root));
+}
+
+void JsonReader::FinishBaseRequests(){
+    AddPendingDistances();
+    SetRoutingInfo();
+    FillBuses();
+    db_->Finalize();
+    db_ = nullptr;
+
+    pending_distances_ = {};
+    pending_buses_ = {};
+    ParseStatRequests();
 }
 
-void JsonReader::AddDistances(){
-    for (const auto& request : stop_parsed_requests_){
-        for (const auto& [to, distance] : request->AsDict().at("road_distances"s).AsDict()){
-            db_.AddDistance(db_.GetStop(std::move(request->AsDict().at("name"s).AsString())) 
-                            , db_.GetStop(std::move(to))
-                            , distance.AsDouble());
-        }       
+// Расстояния от одной остановки идут подряд и добавляются одним пакетом
+void JsonReader::AddPendingDistances(){
+    vector<pair<StopPtr, double>> distances;
+    for (size_t index = 0; index < pending_distances_.size(); ++index){
+        const auto& [from, to, distance] = pending_distances_[index];
+        distances.emplace_back(db_->GetStop(to), distance);
+        if (index + 1 == pending_distances_.size() || pending_distances_[index + 1].from != from){
+            db_->AddDistances(from, distances);
+            distances.clear();
+        }
     }
 }
 
 void JsonReader::FillBuses(){
-    for (const auto& request : bus_parsed_requests_){
-        std::string_view bus_name = std::move(request->AsDict().at("name"s).AsString());
-        json::Array stops = request->AsDict().at("stops"s).AsArray();
-        db_.AddBus(bus_name
-                , std::move(MakeRoute(stops, request->AsDict().at("is_roundtrip"s).AsBool()))
-                , GetEdgeStops(stops));
-
-        render_context_.buses_to_draw.emplace_back(db_.GetBus(bus_name));
+    for (auto& bus : pending_buses_){
+        db_->AddBus(std::move(bus.name)
+                , MakeRoute(bus.stops)
+                , bus.is_roundtrip);
+        bus.stops = {};
     }
 }
 
 void JsonReader::SetRoutingInfo(){
-    json::Node route_info = root_request_.GetRoot().AsDict().at("routing_settings");
-    RouteSettings settings = {route_info.AsDict().at("bus_wait_time").AsDouble()
-                            , route_info.AsDict().at("bus_velocity").AsDouble()};
-    db_.SetRouteSettings(settings);
+    const auto settings = json::schema::Decode<RouteSettings>(root_request_.GetRoot().AsDict().at("routing_settings"s)
+                                                            , "routing_settings"sv);
+    try {
+        CheckRouteSettings(settings);
+    } catch (const json::schema::SchemaError& error){
+        throw error.InKey("routing_settings"sv);
+    }
+    db_->SetRouteSettings(settings);
 }
 
 // Out________________________
 void JsonReader::ParseStatRequests() {
-    if (root_request_.GetRoot().AsDict().count("stat_requests")){
-        temp_requests_ = root_request_.GetRoot().AsDict().at("stat_requests"s).AsArray();
+    json::Dict& root = root_request_.GetRoot().AsDict();
+    if (root.count("stat_requests"s)){
+        temp_requests_ = std::move(root.at("stat_requests"s).AsArray());
+        root.erase("stat_requests"s);
     }
 }
 // Renderer___________________
@@ -129,185 +739,306 @@ void JsonReader::ParseRenderSettings(){
     if(!root_request_.GetRoot().AsDict().count("render_settings"s)){
         return;
     }
-    json::Dict settings = root_request_.GetRoot().AsDict().at("render_settings"s).AsDict();
+    const auto request = json::schema::Decode<requests::RenderSettingsRequest>(
+                root_request_.GetRoot().AsDict().at("render_settings"s), "render_settings"sv);
     renderer::Settings settings_; 
-    settings_.width_ = settings.at("width"s).AsDouble();
-    settings_.height_ = settings.at("height"s).AsDouble();
-    settings_.padding_ = settings.at("padding"s).AsDouble();
+    settings_.width_ = request.width;
+    settings_.height_ = request.height;
+    settings_.padding_ = request.padding;
 
-    settings_.stop_radius_ = settings.at("stop_radius"s).AsDouble();
-    settings_.line_width_ = settings.at("line_width"s).AsDouble();
+    settings_.stop_radius_ = request.stop_radius;
+    settings_.line_width_ = request.line_width;
 
-    settings_.bus_label_font_size_ = settings.at("bus_label_font_size"s).AsDouble();
-    settings_.bus_label_offset_x_ = settings.at("bus_label_offset"s).AsArray().at(0).AsDouble();
-    settings_.bus_label_offset_y_ = settings.at("bus_label_offset"s).AsArray().at(1).AsDouble();
+    settings_.bus_label_font_size_ = request.bus_label_font_size;
+    settings_.bus_label_offset_x_ = request.bus_label_offset.x;
+    settings_.bus_label_offset_y_ = request.bus_label_offset.y;
 
-    settings_.stop_label_font_size_ = settings.at("stop_label_font_size"s).AsDouble();
-    settings_.stop_label_offset_x_ = settings.at("stop_label_offset"s).AsArray().at(0).AsDouble();
-    settings_.stop_label_offset_y_ = settings.at("stop_label_offset"s).AsArray().at(1).AsDouble();
+    settings_.stop_label_font_size_ = request.stop_label_font_size;
+    settings_.stop_label_offset_x_ = request.stop_label_offset.x;
+    settings_.stop_label_offset_y_ = request.stop_label_offset.y;
 
-    settings_.underlayer_color_ = ColorAsString(settings.at("underlayer_color"s));
-    settings_. underlayer_width_ = settings.at("underlayer_width"s).AsDouble();
+    settings_.underlayer_color_ = request.underlayer_color.value;
+    settings_. underlayer_width_ = request.underlayer_width;
 
-    for (const auto& color : settings.at("color_palette").AsArray()){
-        settings_.color_palette_.emplace_back(ColorAsString(color));
+    for (const auto& color : request.color_palette){
+        settings_.color_palette_.emplace_back(color.value);
     }
-    render_context_.render_settings = settings_;
+    render_settings_ = settings_;
 }
-svg::Color JsonReader::ColorAsString(const json::Node& node) const {
-    if (node.IsString()){
-        return node.AsString();
-    }
-
-    json::Array rgb = node.AsArray();
-    std::stringstream color;
-    if (rgb.size() == 3) {
-        color << "rgb("sv
-            << rgb.at(0).AsInt() << ','
-            << rgb.at(1).AsInt() << ','
-            << rgb.at(2).AsInt() << ')';
-    } else {
-        color << "rgba("sv
-            << rgb.at(0).AsInt() << ','
-            << rgb.at(1).AsInt() << ','
-            << rgb.at(2).AsInt() << ','
-            << rgb.at(3).AsDouble() << ')';
-    }
-    
-    return color.str();
-};
 // Stuff______________________
-vector<StopPtr> JsonReader::MakeRoute(const json::Array& stops, bool is_roundtrip) const {
+vector<StopPtr> JsonReader::MakeRoute(const vector<string>& stops) const {
     vector<StopPtr> result;
-    for (const auto& node : stops){
-        result.emplace_back(db_.GetStop(std::move(node.AsString())));
-    }
-    if (is_roundtrip){
-        return result;
-    }
-    auto temp = result;
-    size_t index = temp.size() - 2;
-    for (;index != 0; --index){
-        result.emplace_back(temp[index]);
-    }
-    result.emplace_back(temp[0]);
-    return result; 
-}
-
-json::Node JsonReader::MakeStatNode(const json::Node& request) const {
-    json::Node node;
-
-    if (request.AsDict().at("type"s).AsString()[0] == 'B'){
-        auto info_ptr = db_.GetBusInfo(std::move(request.AsDict().at("name"s).AsString()));
-        if (info_ptr){
-            node = json::Builder{}
-                    .StartDict()
-                        .Key("request_id"s).Value(request.AsDict().at("id"s).AsInt())
-                        .Key("curvature"s).Value(info_ptr->curvature)
-                        .Key("route_length"s).Value(static_cast<int>(info_ptr->route_length))
-                        .Key("stop_count"s).Value(static_cast<int>(info_ptr->stops_count))
-                        .Key("unique_stop_count"s).Value(static_cast<int>(info_ptr->unique_count))
-                    .EndDict()
-                    .Build();
-        } else {
-            node = json::Builder{}
-                    .StartDict()
-                        .Key("request_id"s).Value(request.AsDict().at("id"s).AsInt())
-                        .Key("error_message"s).Value("not found"s)
-                    .EndDict()
-                    .Build();
-        }
-    } else if (request.AsDict().at("type"s).AsString()[0] == 'S'){
-        auto stop_stat = handler_.GetBusesByStop(std::move(request.AsDict().at("name").AsString()));
-        if (stop_stat){
-            node = json::Builder{}
-                    .StartDict()
-                        .Key("request_id"s).Value(request.AsDict().at("id"s).AsInt())
-                        .Key("buses").Value(MakeArray(stop_stat))
-                    .EndDict()
-                    .Build();
+    result.reserve(stops.size());
+    for (const auto& stop : stops){
+        result.emplace_back(db_->GetStop(stop));
+    }
+    return result;
+}
+
+// Ключи словарей ответа пишутся по алфавиту, как их упорядочил бы json::Dict
+void JsonReader::WriteStat(json::Writer& writer, const RequestHandler& handler, const json::Node& request) const {
+    using json::schema::Decode;
+    const std::string_view type = json::schema::GetTag(request, "type"sv);
+
+    if (type == "Bus"sv){
+        const auto bus = Decode<requests::NamedStatRequest>(request);
+        auto info_ptr = handler.GetBusStat(bus.name);
+        if (!info_ptr){
+            WriteNotFound(writer, bus.id);
+            return;
+        }
+        writer.StartDict()
+                .Key("curvature"sv).Value(info_ptr->curvature)
+                .Key("request_id"sv).Value(bus.id)
+                .Key("route_length"sv).Value(static_cast<int>(info_ptr->route_length))
+                .Key("stop_count"sv).Value(static_cast<int>(info_ptr->stops_count))
+                .Key("unique_stop_count"sv).Value(static_cast<int>(info_ptr->unique_count))
+            .EndDict();
+    } else if (type == "Stop"sv){
+        const auto stop = Decode<requests::NamedStatRequest>(request);
+        auto stop_stat = handler.GetBusesByStop(stop.name);
+        if (!stop_stat){
+            WriteNotFound(writer, stop.id);
+            return;
+        }
+        writer.StartDict().Key("buses"sv);
+        WriteBuses(writer, handler, *stop_stat);
+        writer.Key("request_id"sv).Value(stop.id)
+            .EndDict();
+    } else if (type == "CommonBuses"sv){
+        const auto common = Decode<requests::CommonBusesRequest>(request);
+        auto common_buses = handler.GetCommonBuses(common.stops);
+        if (!common_buses){
+            WriteNotFound(writer, common.id);
+            return;
+        }
+        writer.StartDict().Key("buses"sv);
+        WriteBuses(writer, handler, ranges::AsRange(*common_buses));
+        writer.Key("request_id"sv).Value(common.id)
+            .EndDict();
+    } else if (type == "Route"sv || type == "Journey"sv){
+        int id = 0;
+        std::optional<router::Way> best_way;
+        if (type == "Route"sv){
+            const auto route = Decode<requests::RouteRequest>(request);
+            id = route.id;
+            best_way = handler.GetBestWay(route.from, route.to);
         } else {
-            node = json::Builder{}
-                    .StartDict()
-                        .Key("request_id"s).Value(request.AsDict().at("id"s).AsInt())
-                        .Key("error_message"s).Value("not found"s)
-                    .EndDict()
-                    .Build();
-        }
-    } else if (request.AsDict().at("type").AsString()[0] == 'R'){
-        auto best_way = handler_.GetBestWay(std::move(request.AsDict().at("from").AsString())
-                                           ,std::move(request.AsDict().at("to").AsString()));
-        if (best_way){
-            node = json::Builder{}
-                    .StartDict()
-                        .Key("request_id"s).Value(request.AsDict().at("id"s).AsInt())
-                        .Key("total_time").Value(best_way->total_time)
-                        .Key("items").Value(MakeWayArray(*best_way))
-                    .EndDict()
-                    .Build();
+            const auto journey = Decode<requests::JourneyRequest>(request);
+            id = journey.id;
+            best_way = handler.GetBestJourney(journey.from, journey.to);
+        }
+        if (!best_way){
+            WriteNotFound(writer, id);
+            return;
+        }
+        writer.StartDict().Key("items"sv);
+        WriteWay(writer, *best_way);
+        writer.Key("request_id"sv).Value(id)
+                .Key("total_time"sv).Value(best_way->total_time)
+            .EndDict();
+    } else if (type == "NearestStops"sv || type == "StopsInRadius"sv){
+        int id = 0;
+        vector<geo::Neighbour> stops;
+        if (type == "NearestStops"sv){
+            const auto nearest = Decode<requests::NearestStopsRequest>(request);
+            id = nearest.id;
+            stops = handler.GetNearestStops({nearest.latitude, nearest.longitude}, std::max(0, nearest.count));
         } else {
-            node = json::Builder{}
-                    .StartDict()
-                        .Key("request_id"s).Value(request.AsDict().at("id"s).AsInt())
-                        .Key("error_message"s).Value("not found"s)
-                    .EndDict()
-                    .Build();
+            const auto in_radius = Decode<requests::StopsInRadiusRequest>(request);
+            id = in_radius.id;
+            stops = handler.GetStopsInRadius({in_radius.latitude, in_radius.longitude}, in_radius.radius);
+        }
+        writer.StartDict()
+                .Key("request_id"sv).Value(id)
+                .Key("stops"sv);
+        WriteNeighbours(writer, handler, stops);
+        writer.EndDict();
+    } else if (type == "StopsInBox"sv){
+        const auto box = Decode<requests::StopsInBoxRequest>(request);
+        auto stops = handler.GetStopsInBox({box.min_latitude, box.min_longitude},
+                                           {box.max_latitude, box.max_longitude});
+        writer.StartDict()
+                .Key("request_id"sv).Value(box.id)
+                .Key("stops"sv).StartArray();
+        for (StopId stop : stops){
+            writer.Value(handler.GetStopName(stop));
         }
+        writer.EndArray()
+            .EndDict();
+    } else if (type == "Suggest"sv){
+        const auto suggest = Decode<requests::SuggestRequest>(request);
+        const size_t count = std::max(0, suggest.count);
+        auto [first_bus, last_bus] = handler.GetBusesByPrefix(suggest.prefix, count);
+        writer.StartDict()
+                .Key("buses"sv).StartArray();
+        for (BusId bus = first_bus; bus < last_bus; ++bus){
+            writer.Value(handler.GetBusName(bus));
+        }
+        writer.EndArray()
+                .Key("request_id"sv).Value(suggest.id)
+                .Key("stops"sv).StartArray();
+        auto [first_stop, last_stop] = handler.GetStopsByPrefix(suggest.prefix, count);
+        for (StopId stop = first_stop; stop < last_stop; ++stop){
+            writer.Value(handler.GetStopName(stop));
+        }
+        writer.EndArray()
+            .EndDict();
+    } else if (type == "MemoryReport"sv){
+        const int id = Decode<requests::StatRequest>(request).id;
+        writer.StartDict().Key("catalogue"sv);
+        WriteMemoryDict(writer, handler.GetSourceMemoryUsage());
+        writer.Key("map"sv);
+        WriteMemoryDict(writer, handler.GetMapMemoryUsage());
+        writer.Key("request_id"sv).Value(id)
+                .Key("requests"sv);
+        WriteMemoryDict(writer, GetMemoryUsage());
+        writer.Key("router"sv);
+        WriteMemoryDict(writer, handler.GetRouterMemoryUsage());
+        writer.Key("snapshot"sv);
+        WriteMemoryDict(writer, handler.GetCatalogueMemoryUsage());
+        writer.EndDict();
     } else {
-        std::stringstream stream;
-        handler_.RenderMap().Render(stream);
+        const int id = Decode<requests::StatRequest>(request).id;
+        writer.StartDict()
+                .Key("map"sv).Value(handler.GetRenderedMap())
+                .Key("request_id"sv).Value(id)
+            .EndDict();
+    }
+}
+
+void JsonReader::WriteNotFound(json::Writer& writer, int id){
+    writer.StartDict()
+            .Key("error_message"sv).Value("not found"sv)
+            .Key("request_id"sv).Value(id)
+        .EndDict();
+}
+
+void JsonReader::WriteBuses(json::Writer& writer, const RequestHandler& handler, FrozenCatalogue::BusRange buses) const {
+    writer.StartArray();
+    for (BusId bus : buses){
+        writer.Value(handler.GetBusName(bus));
+    }
+    writer.EndArray();
+}
 
-        node = json::Builder{}
-                .StartDict()
-                    .Key("request_id"s).Value(request.AsDict().at("id"s).AsInt())
-                    .Key("map").Value(stream.str())
-                .EndDict()
-                .Build();
-        stream.clear();
+
+void JsonReader::WriteNeighbours(json::Writer& writer, const RequestHandler& handler, const vector<geo::Neighbour>& stops) const {
+    writer.StartArray();
+    for (const auto& stop : stops){
+        writer.StartDict()
+                .Key("distance"sv).Value(stop.distance)
+                .Key("name"sv).Value(handler.GetStopName(stop.index))
+            .EndDict();
     }
-    return node;    
+    writer.EndArray();
 }
 
-json::Array JsonReader::MakeArray(const set<sv>* set) const {
-    json::Array result;
-    for (const auto& elem : *set){
-        result.emplace_back(std::string(elem));
+void JsonReader::WriteMemoryDict(json::Writer& writer, memory::Report report) const {
+    sort(report.begin(), report.end(), [](const auto& lhs, const auto& rhs){
+        return lhs.first < rhs.first;
+    });
+    writer.StartDict();
+    for (const auto& [name, usage] : report){
+        // Значения больше INT_MAX не представимы в json::Node
+        writer.Key(name).StartDict()
+                .Key("bytes"sv).Value(static_cast<int>(std::min<size_t>(usage.bytes, numeric_limits<int>::max())))
+                .Key("count"sv).Value(static_cast<int>(std::min<size_t>(usage.count, numeric_limits<int>::max())))
+            .EndDict();
     }
-    return result;
-} 
+    writer.EndDict();
+}
 
+// Входной документ и копия запросов к базе, которые хранит JsonReader
+memory::Report JsonReader::GetMemoryUsage() const {
+    memory::Usage stat_requests{memory::VectorBytes(temp_requests_), 0};
+    for (const auto& request : temp_requests_){
+        stat_requests += json::GetMemoryUsage(request);
+    }
+    return {{"document"s, root_request_.GetMemoryUsage()},
+            {"stat_requests"s, stat_requests}};
+}
 
-json::Array JsonReader::MakeWayArray(const router::Way& way) const {
-    json::Array result;
+void JsonReader::WriteWay(json::Writer& writer, const router::Way& way) const {
+    writer.StartArray();
     for (const auto& elem : way.way){
-        json::Node temp;
-        if (elem.type[0] == 'W'){
-            temp = json::Builder{}
-                .StartDict()
-                    .Key("type").Value(elem.type)
-                    .Key("stop_name").Value(std::string(elem.name))
-                    .Key("time").Value(elem.time)
-                .EndDict()
-                .Build();
+        if (elem.type == "Walk"sv){
+            writer.StartDict();
+            // Последний пеший участок ведёт не к остановке, а к точке назначения
+            if (!elem.name.empty()){
+                writer.Key("stop_name"sv).Value(elem.name);
+            }
+            writer.Key("time"sv).Value(elem.time)
+                    .Key("type"sv).Value(elem.type)
+                .EndDict();
+        } else if (elem.type == "Wait"sv){
+            writer.StartDict()
+                    .Key("stop_name"sv).Value(elem.name)
+                    .Key("time"sv).Value(elem.time)
+                    .Key("type"sv).Value(elem.type)
+                .EndDict();
         } else {
-            temp = json::Builder{}
-                .StartDict()
-                    .Key("type").Value(elem.type)
-                    .Key("bus").Value(std::string(elem.name))
-                    .Key("time").Value((elem.time))
-                    .Key("span_count").Value(static_cast<int>(elem.span_count))
-                .EndDict()
-                .Build();
+            writer.StartDict()
+                    .Key("bus"sv).Value(elem.name)
+                    .Key("span_count"sv).Value(static_cast<int>(elem.span_count))
+                    .Key("time"sv).Value(elem.time)
+                    .Key("type"sv).Value(elem.type)
+                .EndDict();
+        }
     }
-        result.emplace_back(temp);
+    writer.EndArray();
+}
+
+//--------------------- MultiCityJsonReader ------------------------
+
+MultiCityJsonReader::MultiCityJsonReader(MultiCityCatalogue& cities, json::Document document)
+: cities_(cities){
+    json::Dict& root = document.GetRoot().AsDict();
+    for (auto& [name, city] : root.at("cities"s).AsDict()){
+        auto& reader = readers_[name];
+        cities_.AddCity(name).Update([&reader, &city = city](TransportCatalogue& db, renderer::Settings& render_settings){
+            reader = std::make_unique<JsonReader>(db, json::Document(std::move(city)));
+            render_settings = reader->GetRenderSettings();
+        });
+        // Изменения публикуются следующей версией города. Ошибка в них не мешает остальным городам.
+        if (const json::Node* delta = reader->GetDeltaRequests()){
+            try {
+                cities_.AddCity(name).Update([delta](TransportCatalogue& db, renderer::Settings&){
+                    ApplyDelta(db, *delta);
+                });
+            } catch (const json::schema::SchemaError& error){
+                cerr << error.InKey(name).InKey("cities"sv).what() << '\n';
+            }
+        }
     }
-    return result;
+    if (root.count("stat_requests"s)){
+        stat_requests_ = std::move(root.at("stat_requests"s).AsArray());
+    }
+    print_mode_ = GetPrintMode(root);
 }
-std::vector<StopPtr> JsonReader::GetEdgeStops(const json::Array& stops) const {
-    if (stops.empty()){
-        return{};
+
+void MultiCityJsonReader::PrintStat(std::ostream& out) const {
+    if (stat_requests_.empty()){
+        return;
     }
-    return std::vector<StopPtr>{
-                    db_.GetStop(stops.front().AsString()),
-                    db_.GetStop(stops.back().AsString())};
-}
\ No newline at end of file
+    json::Writer writer(out, print_mode_);
+    writer.StartArray();
+    for (size_t index = 0; index < stat_requests_.size(); ++index){
+        try {
+            const json::Node& request = stat_requests_[index];
+            const auto city_request = json::schema::Decode<requests::CityStatRequest>(request);
+            auto reader = readers_.find(city_request.city);
+            const VersionedCatalogue* city = cities_.FindCity(city_request.city);
+            if (reader == readers_.end() || city == nullptr){
+                JsonReader::WriteNotFound(writer, city_request.id);
+                continue;
+            }
+            auto version = city->Pin();
+            reader->second->WriteStat(writer, version->handler, request);
+        } catch (const json::schema::SchemaError& error){
+            throw error.InItem(index).InKey("stat_requests"sv);
+        }
+    }
+    writer.EndArray();
+    out.flush();
+}
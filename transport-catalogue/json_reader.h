@@ -1,51 +1,117 @@
 #pragma once
 
 #include "json.h"
+#include "json_arena.h"
+#include "json_requests.h"
+#include "json_writer.h"
 #include "map_renderer.h"
+#include "multi_city_catalogue.h"
 #include "request_handler.h"
+#include "transport_catalogue.h"
+
+#include <map>
+#include <memory>
+#include <thread>
 
 namespace reader{
 
+// Применяет массив delta_requests к справочнику. Пачка проверяется целиком до изменений:
+// при ошибке бросается json::schema::SchemaError с номером запроса, и справочник не меняется.
+// Обычно вызывается из VersionedCatalogue::Update().
+void ApplyDelta(TransportCatalogue& db, const json::Node& delta_requests);
 
 class JsonReader{
 public:
-    JsonReader(TransportCatalogue& db, const RequestHandler& handler, std::istream& in);
+    JsonReader(TransportCatalogue& db, std::istream& in);
+    JsonReader(TransportCatalogue& db, json::Document document);
+
+    // Меньший вход разбирается потоково в одном потоке
+    static constexpr size_t PARALLEL_INPUT_SIZE = 1 << 20;
+
+    // Загрузка из текста без построения всего документа. Вход меньше parallel_input_size
+    // разбирается потоково: запросы base_requests применяются по мере разбора. Крупный вход
+    // сначала быстро делится на элементы base_requests и stat_requests, которые разбираются
+    // не больше чем в threads потоках одновременно.
+    JsonReader(TransportCatalogue& db, std::string_view input,
+               size_t threads = std::thread::hardware_concurrency(),
+               size_t parallel_input_size = PARALLEL_INPUT_SIZE);
 
     void FillCatalogue();
-    json::Document MakeOutDocument() const;
-    void PrintStat(std::ostream& out);
-    renderer::RenderContext GetRenderContext() const;
+    void PrintStat(const RequestHandler& handler, std::ostream& out) const;
+    renderer::Settings GetRenderSettings() const;
+    // Раздел delta_requests или nullptr. Применяется отдельно через ApplyDelta().
+    const json::Node* GetDeltaRequests() const;
+    // Ответ на один запрос к базе
+    void WriteStat(json::Writer& writer, const RequestHandler& handler, const json::Node& request) const;
+    static void WriteNotFound(json::Writer& writer, int id);
 
 private:
 // Entry______________________
-    void ParseEntryRequests();
-    void FillStops();
-    void AddDistances();
+    // Остановка и расстояния до известных остановок добавляются сразу,
+    // автобус откладывается до загрузки всех остановок
+    void AddBaseRequest(const requests::BaseRequest& request);
+    void LoadStreaming(std::string_view input);
+    void LoadParallel(std::string_view input, size_t threads);
+    void FinishBaseRequests();
+    void AddPendingDistances();
     void FillBuses();
     void SetRoutingInfo();
 
-    std::vector<const json::Node*> bus_parsed_requests_;
-    std::vector<const json::Node*> stop_parsed_requests_;
+    // Расстояние до остановки, которая ещё не загружена
+    struct PendingDistance {
+        StopPtr from;
+        std::string to;
+        double distance;
+    };
+    // Автобус, ожидающий загрузки остановок маршрута
+    struct PendingBus {
+        std::string name;
+        std::vector<std::string> stops;
+        bool is_roundtrip;
+    };
+
+    // Имена и маршруты забираются из разобранного документа
+    std::vector<PendingDistance> pending_distances_;
+    std::vector<PendingBus> pending_buses_;
     json::Array temp_requests_;
 // Out________________________
     void ParseStatRequests();
 
 // Render_____________________
     void ParseRenderSettings();
-    svg::Color ColorAsString(const json::Node& node) const;
 
 // Stuff______________________
-    std::vector<StopPtr> MakeRoute(const json::Array& stops, bool is_roundtrip) const;
-    json::Node MakeStatNode(const json::Node& request) const;
-    json::Array MakeArray(const std::set<sv>* set) const;
-    std::vector<StopPtr> GetEdgeStops(const json::Array& stops) const;
-    json::Array MakeWayArray(const router::Way& way) const;
-
-    TransportCatalogue& db_;
-    RequestHandler handler_;
+    std::vector<StopPtr> MakeRoute(const std::vector<std::string>& stops) const;
+    void WriteBuses(json::Writer& writer, const RequestHandler& handler, FrozenCatalogue::BusRange buses) const;
+    void WriteWay(json::Writer& writer, const router::Way& way) const;
+    void WriteNeighbours(json::Writer& writer, const RequestHandler& handler, const std::vector<geo::Neighbour>& stops) const;
+    void WriteMemoryDict(json::Writer& writer, memory::Report report) const;
+    memory::Report GetMemoryUsage() const;
+
+    // Справочник нужен только при загрузке и после неё обнуляется:
+    // VersionedCatalogue::Update() перемещает заполненную копию в себя
+    TransportCatalogue* db_;
     json::Document root_request_;
 
-    renderer::RenderContext render_context_;
+    renderer::Settings render_settings_;
+    json::PrintMode print_mode_ = json::PrintMode::PRETTY;
+};
+
+// Входные данные нескольких городов:
+// {"cities": {"<город>": {"base_requests": ..., "render_settings": ..., "routing_settings": ...}},
+//  "stat_requests": [{"city": "<город>", ...}]}
+// Каждый город загружается своим JsonReader, запросы к базе направляются по полю city.
+class MultiCityJsonReader{
+public:
+    MultiCityJsonReader(MultiCityCatalogue& cities, json::Document document);
+
+    void PrintStat(std::ostream& out) const;
+
+private:
+    MultiCityCatalogue& cities_;
+    json::Array stat_requests_;
+    json::PrintMode print_mode_ = json::PrintMode::PRETTY;
+    std::map<std::string, std::unique_ptr<JsonReader>, std::less<>> readers_;
 };
 
 
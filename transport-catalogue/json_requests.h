@@ -0,0 +1,359 @@
+#pragma once
+
+#include "domain.h"
+#include "geo.h"
+#include "json_schema.h"
+#include "svg.h"
+
+#include <sstream>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+// Запросы входного документа в виде структур. Строки ссылаются на разобранный документ.
+namespace reader::requests {
+
+// base_requests и delta_requests
+
+struct StopRequest {
+    std::string_view name;
+    double latitude = 0;
+    double longitude = 0;
+    json::schema::Entries<double> road_distances;
+};
+
+struct BusRequest {
+    std::string_view name;
+    std::vector<std::string_view> stops;
+    bool is_roundtrip = false;
+};
+
+using BaseRequest = std::variant<StopRequest, BusRequest>;
+
+struct DistanceRequest {
+    std::string_view from;
+    std::string_view to;
+    double distance = 0;
+};
+
+// "delete": true у запроса delta_requests
+struct DeletionMark {
+    bool is_deletion = false;
+};
+
+// Удаление остановки или автобуса
+struct RemoveRequest {
+    std::string_view name;
+};
+
+struct RemoveDistanceRequest {
+    std::string_view from;
+    std::string_view to;
+};
+
+// render_settings
+
+struct Offset {
+    double x = 0;
+    double y = 0;
+};
+
+// Строка или массив [r, g, b] либо [r, g, b, a]
+struct Color {
+    svg::Color value;
+};
+
+struct RenderSettingsRequest {
+    double width = 0;
+    double height = 0;
+    double padding = 0;
+    double stop_radius = 0;
+    double line_width = 0;
+    double bus_label_font_size = 0;
+    Offset bus_label_offset;
+    double stop_label_font_size = 0;
+    Offset stop_label_offset;
+    Color underlayer_color;
+    double underlayer_width = 0;
+    std::vector<Color> color_palette;
+};
+
+// stat_requests. Тип запроса читается до разбора, id есть у каждого.
+
+struct StatRequest {
+    int id = 0;
+};
+
+// Bus и Stop
+struct NamedStatRequest {
+    int id = 0;
+    std::string_view name;
+};
+
+struct CommonBusesRequest {
+    int id = 0;
+    std::vector<std::string_view> stops;
+};
+
+struct RouteRequest {
+    int id = 0;
+    std::string_view from;
+    std::string_view to;
+};
+
+struct JourneyRequest {
+    int id = 0;
+    geo::Coordinates from;
+    geo::Coordinates to;
+};
+
+struct NearestStopsRequest {
+    int id = 0;
+    double latitude = 0;
+    double longitude = 0;
+    int count = 0;
+};
+
+struct StopsInRadiusRequest {
+    int id = 0;
+    double latitude = 0;
+    double longitude = 0;
+    double radius = 0;
+};
+
+struct StopsInBoxRequest {
+    int id = 0;
+    double min_latitude = 0;
+    double min_longitude = 0;
+    double max_latitude = 0;
+    double max_longitude = 0;
+};
+
+struct SuggestRequest {
+    int id = 0;
+    std::string_view prefix;
+    int count = 0;
+};
+
+// Запрос к одному из городов MultiCityJsonReader
+struct CityStatRequest {
+    int id = 0;
+    std::string_view city;
+};
+
+}  // namespace reader::requests
+
+namespace json::schema {
+
+template <>
+struct Schema<reader::requests::StopRequest> {
+    using T = reader::requests::StopRequest;
+    static constexpr auto fields = std::make_tuple(
+        Required("name", &T::name),
+        Required("latitude", &T::latitude),
+        Required("longitude", &T::longitude),
+        Optional("road_distances", &T::road_distances));
+};
+
+template <>
+struct Schema<reader::requests::BusRequest> {
+    using T = reader::requests::BusRequest;
+    static constexpr auto fields = std::make_tuple(
+        Required("name", &T::name),
+        Required("stops", &T::stops),
+        Required("is_roundtrip", &T::is_roundtrip));
+};
+
+template <>
+struct Schema<reader::requests::DistanceRequest> {
+    using T = reader::requests::DistanceRequest;
+    static constexpr auto fields = std::make_tuple(
+        Required("from", &T::from),
+        Required("to", &T::to),
+        Required("distance", &T::distance));
+};
+
+template <>
+struct Schema<reader::requests::DeletionMark> {
+    using T = reader::requests::DeletionMark;
+    static constexpr auto fields = std::make_tuple(
+        Optional("delete", &T::is_deletion));
+};
+
+template <>
+struct Schema<reader::requests::RemoveRequest> {
+    using T = reader::requests::RemoveRequest;
+    static constexpr auto fields = std::make_tuple(
+        Required("name", &T::name));
+};
+
+template <>
+struct Schema<reader::requests::RemoveDistanceRequest> {
+    using T = reader::requests::RemoveDistanceRequest;
+    static constexpr auto fields = std::make_tuple(
+        Required("from", &T::from),
+        Required("to", &T::to));
+};
+
+template <>
+struct Schema<RouteSettings> {
+    using T = RouteSettings;
+    static constexpr auto fields = std::make_tuple(
+        Required("bus_wait_time", &T::wait_time),
+        Required("bus_velocity", &T::velocity),
+        Optional("pedestrian_velocity", &T::pedestrian_velocity),
+        Optional("walk_radius", &T::walk_radius));
+};
+
+template <>
+struct Schema<reader::requests::RenderSettingsRequest> {
+    using T = reader::requests::RenderSettingsRequest;
+    static constexpr auto fields = std::make_tuple(
+        Required("width", &T::width),
+        Required("height", &T::height),
+        Required("padding", &T::padding),
+        Required("stop_radius", &T::stop_radius),
+        Required("line_width", &T::line_width),
+        Required("bus_label_font_size", &T::bus_label_font_size),
+        Required("bus_label_offset", &T::bus_label_offset),
+        Required("stop_label_font_size", &T::stop_label_font_size),
+        Required("stop_label_offset", &T::stop_label_offset),
+        Required("underlayer_color", &T::underlayer_color),
+        Required("underlayer_width", &T::underlayer_width),
+        Required("color_palette", &T::color_palette));
+};
+
+template <>
+struct Schema<geo::Coordinates> {
+    using T = geo::Coordinates;
+    static constexpr auto fields = std::make_tuple(
+        Required("latitude", &T::lat),
+        Required("longitude", &T::lng));
+};
+
+template <>
+struct Schema<reader::requests::StatRequest> {
+    using T = reader::requests::StatRequest;
+    static constexpr auto fields = std::make_tuple(
+        Required("id", &T::id));
+};
+
+template <>
+struct Schema<reader::requests::NamedStatRequest> {
+    using T = reader::requests::NamedStatRequest;
+    static constexpr auto fields = std::make_tuple(
+        Required("id", &T::id),
+        Required("name", &T::name));
+};
+
+template <>
+struct Schema<reader::requests::CommonBusesRequest> {
+    using T = reader::requests::CommonBusesRequest;
+    static constexpr auto fields = std::make_tuple(
+        Required("id", &T::id),
+        Required("stops", &T::stops));
+};
+
+template <>
+struct Schema<reader::requests::RouteRequest> {
+    using T = reader::requests::RouteRequest;
+    static constexpr auto fields = std::make_tuple(
+        Required("id", &T::id),
+        Required("from", &T::from),
+        Required("to", &T::to));
+};
+
+template <>
+struct Schema<reader::requests::JourneyRequest> {
+    using T = reader::requests::JourneyRequest;
+    static constexpr auto fields = std::make_tuple(
+        Required("id", &T::id),
+        Required("from", &T::from),
+        Required("to", &T::to));
+};
+
+template <>
+struct Schema<reader::requests::NearestStopsRequest> {
+    using T = reader::requests::NearestStopsRequest;
+    static constexpr auto fields = std::make_tuple(
+        Required("id", &T::id),
+        Required("latitude", &T::latitude),
+        Required("longitude", &T::longitude),
+        Required("count", &T::count));
+};
+
+template <>
+struct Schema<reader::requests::StopsInRadiusRequest> {
+    using T = reader::requests::StopsInRadiusRequest;
+    static constexpr auto fields = std::make_tuple(
+        Required("id", &T::id),
+        Required("latitude", &T::latitude),
+        Required("longitude", &T::longitude),
+        Required("radius", &T::radius));
+};
+
+template <>
+struct Schema<reader::requests::StopsInBoxRequest> {
+    using T = reader::requests::StopsInBoxRequest;
+    static constexpr auto fields = std::make_tuple(
+        Required("id", &T::id),
+        Required("min_latitude", &T::min_latitude),
+        Required("min_longitude", &T::min_longitude),
+        Required("max_latitude", &T::max_latitude),
+        Required("max_longitude", &T::max_longitude));
+};
+
+template <>
+struct Schema<reader::requests::SuggestRequest> {
+    using T = reader::requests::SuggestRequest;
+    static constexpr auto fields = std::make_tuple(
+        Required("id", &T::id),
+        Required("prefix", &T::prefix),
+        Required("count", &T::count));
+};
+
+template <>
+struct Schema<reader::requests::CityStatRequest> {
+    using T = reader::requests::CityStatRequest;
+    static constexpr auto fields = std::make_tuple(
+        Required("id", &T::id),
+        Required("city", &T::city));
+};
+
+template <>
+struct Decoder<reader::requests::Offset> {
+    template <typename Node>
+    static reader::requests::Offset Decode(const Node& node) {
+        if (!node.IsArray() || node.AsArray().size() != 2) {
+            throw SchemaError({}, "expected an array of 2 numbers");
+        }
+        const auto& items = node.AsArray();
+        return {json::schema::Decode<double>(items[0], "[0]"), json::schema::Decode<double>(items[1], "[1]")};
+    }
+};
+
+template <>
+struct Decoder<reader::requests::Color> {
+    template <typename Node>
+    static reader::requests::Color Decode(const Node& node) {
+        if (node.IsString()) {
+            return {svg::Color(node.AsString())};
+        }
+        if (!node.IsArray() || (node.AsArray().size() != 3 && node.AsArray().size() != 4)) {
+            throw SchemaError({}, "expected a string or an array of 3 or 4 numbers");
+        }
+        const auto& rgb = node.AsArray();
+        std::ostringstream color;
+        color << (rgb.size() == 3 ? "rgb(" : "rgba(")
+              << json::schema::Decode<int>(rgb[0], "[0]") << ','
+              << json::schema::Decode<int>(rgb[1], "[1]") << ','
+              << json::schema::Decode<int>(rgb[2], "[2]");
+        if (rgb.size() == 4) {
+            color << ',' << json::schema::Decode<double>(rgb[3], "[3]");
+        }
+        color << ')';
+        return {color.str()};
+    }
+};
+
+}  // namespace json::schema
@@ -0,0 +1,264 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Разбор словарей JSON в структуры по схеме, заданной на этапе компиляции.
+// Схема типа T — специализация Schema<T> со списком полей: ключ и указатель на член.
+// Словарь обходится один раз, каждое значение сразу записывается в свой член.
+// Работает с любыми узлами с интерфейсом json::Node: json::Node и json::arena::Node.
+namespace json::schema {
+
+// Несоответствие схеме. Путь до значения вида "render_settings.color_palette[2]".
+class SchemaError : public std::runtime_error {
+public:
+    SchemaError(std::string path, std::string message)
+        : runtime_error(path.empty() ? message : path + ": " + message)
+        , path_(std::move(path))
+        , message_(std::move(message)) {
+    }
+
+    const std::string& GetPath() const {
+        return path_;
+    }
+
+    // Та же ошибка внутри значения по ключу key
+    SchemaError InKey(std::string_view key) const {
+        std::string path(key);
+        if (!path_.empty() && path_.front() != '[') {
+            path += '.';
+        }
+        return {path + path_, message_};
+    }
+
+    // Та же ошибка внутри элемента массива
+    SchemaError InItem(size_t index) const {
+        return InKey("[" + std::to_string(index) + "]");
+    }
+
+private:
+    std::string path_;
+    std::string message_;
+};
+
+template <typename Object, typename Value>
+struct Field {
+    std::string_view key;
+    Value Object::* member;
+    bool is_required;
+};
+
+template <typename Object, typename Value>
+constexpr Field<Object, Value> Required(std::string_view key, Value Object::* member) {
+    return {key, member, true};
+}
+
+// Отсутствующее поле сохраняет значение по умолчанию из определения структуры
+template <typename Object, typename Value>
+constexpr Field<Object, Value> Optional(std::string_view key, Value Object::* member) {
+    return {key, member, false};
+}
+
+// Специализация задаёт static constexpr auto fields = std::make_tuple(Required(...), Optional(...), ...)
+template <typename T>
+struct Schema;
+
+// Пары ключ — значение словаря с произвольными ключами в порядке обхода
+template <typename T>
+using Entries = std::vector<std::pair<std::string_view, T>>;
+
+// Разбор одного значения. Строки std::string_view ссылаются на узел и живут, пока жив документ.
+// Свои типы значений добавляются специализацией со статическим шаблоном Decode(const Node&).
+template <typename T>
+struct Decoder;
+
+template <typename T, typename Node>
+T Decode(const Node& node) {
+    return Decoder<T>::Decode(node);
+}
+
+// Ошибка внутри разбора получает в путь ключ path
+template <typename T, typename Node>
+T Decode(const Node& node, std::string_view path) {
+    try {
+        return Decoder<T>::Decode(node);
+    } catch (const SchemaError& error) {
+        throw error.InKey(path);
+    }
+}
+
+// Строковое значение по ключу, например тип запроса, до разбора по схеме этого типа.
+// Ключи словаря упорядочены, поэтому обход прекращается на первом большем ключе.
+template <typename Node>
+std::string_view GetTag(const Node& node, std::string_view key) {
+    if (!node.IsDict()) {
+        throw SchemaError({}, "expected a dict");
+    }
+    for (const auto& [name, value] : node.AsDict()) {
+        if (name == key) {
+            if (!value.IsString()) {
+                throw SchemaError(std::string(key), "expected a string");
+            }
+            return value.AsString();
+        }
+        if (std::string_view(name) > key) {
+            break;
+        }
+    }
+    throw SchemaError(std::string(key), "missing required key");
+}
+
+namespace detail {
+
+template <typename Object, typename Value, typename Node>
+void DecodeField(Object& object, const Field<Object, Value>& field, const Node& node) {
+    try {
+        object.*field.member = Decoder<Value>::Decode(node);
+    } catch (const SchemaError& error) {
+        throw error.InKey(field.key);
+    }
+}
+
+template <typename Object, typename Node, typename Fields, size_t... I>
+void DecodeMember(Object& object, std::string_view key, const Node& node, const Fields& fields,
+                  std::uint64_t& seen, std::index_sequence<I...>) {
+    // Ключи, которых нет в схеме, пропускаются
+    (void)((key == std::get<I>(fields).key
+            ? (DecodeField(object, std::get<I>(fields), node), seen |= std::uint64_t{1} << I, true)
+            : false) || ...);
+}
+
+template <typename Fields, size_t... I>
+void CheckRequired(const Fields& fields, std::uint64_t seen, std::index_sequence<I...>) {
+    (void)((std::get<I>(fields).is_required && !(seen >> I & 1)
+            ? throw SchemaError(std::string(std::get<I>(fields).key), "missing required key")
+            : false) || ...);
+}
+
+}  // namespace detail
+
+// Словарь разбирается по схеме Schema<T>
+template <typename T>
+struct Decoder {
+    template <typename Node>
+    static T Decode(const Node& node) {
+        constexpr const auto& fields = Schema<T>::fields;
+        constexpr size_t size = std::tuple_size_v<std::decay_t<decltype(fields)>>;
+        static_assert(size <= 64, "Too many fields in a schema");
+        using Indexes = std::make_index_sequence<size>;
+
+        if (!node.IsDict()) {
+            throw SchemaError({}, "expected a dict");
+        }
+        T result{};
+        std::uint64_t seen = 0;
+        for (const auto& [key, value] : node.AsDict()) {
+            detail::DecodeMember(result, key, value, fields, seen, Indexes{});
+        }
+        detail::CheckRequired(fields, seen, Indexes{});
+        return result;
+    }
+};
+
+template <>
+struct Decoder<bool> {
+    template <typename Node>
+    static bool Decode(const Node& node) {
+        if (!node.IsBool()) {
+            throw SchemaError({}, "expected a bool");
+        }
+        return node.AsBool();
+    }
+};
+
+template <>
+struct Decoder<int> {
+    template <typename Node>
+    static int Decode(const Node& node) {
+        if (!node.IsInt()) {
+            throw SchemaError({}, "expected an int");
+        }
+        return node.AsInt();
+    }
+};
+
+// Целые числа тоже подходят
+template <>
+struct Decoder<double> {
+    template <typename Node>
+    static double Decode(const Node& node) {
+        if (!node.IsDouble()) {
+            throw SchemaError({}, "expected a number");
+        }
+        return node.AsDouble();
+    }
+};
+
+template <>
+struct Decoder<std::string_view> {
+    template <typename Node>
+    static std::string_view Decode(const Node& node) {
+        if (!node.IsString()) {
+            throw SchemaError({}, "expected a string");
+        }
+        return node.AsString();
+    }
+};
+
+template <>
+struct Decoder<std::string> {
+    template <typename Node>
+    static std::string Decode(const Node& node) {
+        return std::string(Decoder<std::string_view>::Decode(node));
+    }
+};
+
+template <typename T>
+struct Decoder<std::vector<T>> {
+    template <typename Node>
+    static std::vector<T> Decode(const Node& node) {
+        if (!node.IsArray()) {
+            throw SchemaError({}, "expected an array");
+        }
+        const auto& items = node.AsArray();
+        std::vector<T> result;
+        result.reserve(items.size());
+        for (const auto& item : items) {
+            try {
+                result.push_back(Decoder<T>::Decode(item));
+            } catch (const SchemaError& error) {
+                throw error.InItem(result.size());
+            }
+        }
+        return result;
+    }
+};
+
+template <typename T>
+struct Decoder<Entries<T>> {
+    template <typename Node>
+    static Entries<T> Decode(const Node& node) {
+        if (!node.IsDict()) {
+            throw SchemaError({}, "expected a dict");
+        }
+        const auto& dict = node.AsDict();
+        Entries<T> result;
+        result.reserve(dict.size());
+        for (const auto& [key, value] : dict) {
+            try {
+                result.emplace_back(key, Decoder<T>::Decode(value));
+            } catch (const SchemaError& error) {
+                throw error.InKey(key);
+            }
+        }
+        return result;
+    }
+};
+
+}  // namespace json::schema
@@ -0,0 +1,153 @@
+#include "json_writer.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std::literals;
+
+namespace json {
+
+namespace {
+
+// Тот же шаг отступа, что и у json::Print
+constexpr int INDENT_STEP = 4;
+
+// Отступы выводятся кусками этой строки
+constexpr std::string_view SPACES = "                                "sv;
+
+}  // namespace
+
+Writer::Writer(std::ostream& out, PrintMode mode)
+    : out_(out)
+    , mode_(mode)
+{}
+
+Writer::DictValueContext Writer::Key(std::string_view key) {
+    if (frames_.empty() || !frames_.back().is_dict || is_key_written_) {
+        throw std::logic_error("Key() outside a dict"s);
+    }
+    WriteSeparator();
+    PrintString(key, out_);
+    out_ << (mode_ == PrintMode::PRETTY ? ": "sv : ":"sv);
+    is_key_written_ = true;
+    return BaseContext{*this};
+}
+
+Writer::BaseContext Writer::Value(const Node& value) {
+    StartItem();
+    Print(value, out_, static_cast<int>(frames_.size()) * INDENT_STEP, mode_);
+    return *this;
+}
+
+Writer::BaseContext Writer::Value(std::string_view value) {
+    StartItem();
+    PrintString(value, out_);
+    return *this;
+}
+
+Writer::BaseContext Writer::Value(const char* value) {
+    return Value(std::string_view(value));
+}
+
+Writer::BaseContext Writer::Value(const std::string& value) {
+    return Value(std::string_view(value));
+}
+
+// Числа выводятся так же, как их выводит json::Print
+Writer::BaseContext Writer::Value(int value) {
+    StartItem();
+    out_ << value;
+    return *this;
+}
+
+Writer::BaseContext Writer::Value(double value) {
+    StartItem();
+    out_ << value;
+    return *this;
+}
+
+Writer::BaseContext Writer::Value(bool value) {
+    StartItem();
+    out_ << (value ? "true"sv : "false"sv);
+    return *this;
+}
+
+Writer::DictItemContext Writer::StartDict() {
+    StartItem();
+    out_.put('{');
+    PrintNewLine();
+    frames_.push_back({true});
+    return BaseContext{*this};
+}
+
+Writer::ArrayItemContext Writer::StartArray() {
+    StartItem();
+    out_.put('[');
+    PrintNewLine();
+    frames_.push_back({false});
+    return BaseContext{*this};
+}
+
+Writer::BaseContext Writer::EndDict() {
+    EndContainer(true);
+    out_.put('}');
+    return *this;
+}
+
+Writer::BaseContext Writer::EndArray() {
+    EndContainer(false);
+    out_.put(']');
+    return *this;
+}
+
+// Значение словаря пишется сразу после ключа, элемент массива — с новой строки
+void Writer::StartItem() {
+    if (frames_.empty()) {
+        return;
+    }
+    if (!frames_.back().is_dict) {
+        WriteSeparator();
+        return;
+    }
+    if (!is_key_written_) {
+        throw std::logic_error("Value without a key"s);
+    }
+    is_key_written_ = false;
+}
+
+void Writer::WriteSeparator() {
+    Frame& frame = frames_.back();
+    if (!frame.is_empty) {
+        out_.put(',');
+        PrintNewLine();
+    }
+    frame.is_empty = false;
+    PrintIndent();
+}
+
+void Writer::PrintIndent() const {
+    if (mode_ == PrintMode::COMPACT) {
+        return;
+    }
+    for (size_t left = frames_.size() * INDENT_STEP; left > 0;) {
+        const size_t part = std::min(left, SPACES.size());
+        out_.write(SPACES.data(), part);
+        left -= part;
+    }
+}
+
+void Writer::PrintNewLine() const {
+    if (mode_ == PrintMode::PRETTY) {
+        out_.put('\n');
+    }
+}
+
+void Writer::EndContainer(bool is_dict) {
+    if (frames_.empty() || frames_.back().is_dict != is_dict || is_key_written_) {
+        throw std::logic_error(is_dict ? "EndDict() outside a dict"s : "EndArray() outside an array"s);
+    }
+    frames_.pop_back();
+    PrintNewLine();
+    PrintIndent();
+}
+
+}  // namespace json
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "json.h"
+
+namespace json {
+
+// Пишет JSON сразу в поток, не строя дерево узлов. Порядок вызовов проверяется
+// так же, как в Builder, а вывод совпадает с json::Print: ключи словаря
+// выводятся в порядке вызовов Key(), поэтому для совпадения их задают по алфавиту.
+// Строки, числа и логические значения пишутся напрямую, без промежуточного Node.
+class Writer {
+private:
+    class BaseContext;
+    class DictValueContext;
+    class DictItemContext;
+    class ArrayItemContext;
+
+public:
+    explicit Writer(std::ostream& out, PrintMode mode = PrintMode::PRETTY);
+    DictValueContext Key(std::string_view key);
+    BaseContext Value(const Node& value);
+    BaseContext Value(std::string_view value);
+    // Без этих перегрузок строка выбрала бы Value(bool) или оказалась неоднозначной
+    BaseContext Value(const char* value);
+    BaseContext Value(const std::string& value);
+    BaseContext Value(int value);
+    BaseContext Value(double value);
+    BaseContext Value(bool value);
+    DictItemContext StartDict();
+    ArrayItemContext StartArray();
+    BaseContext EndDict();
+    BaseContext EndArray();
+
+private:
+    struct Frame {
+        bool is_dict;
+        bool is_empty = true;
+    };
+
+    std::ostream& out_;
+    PrintMode mode_;
+    std::vector<Frame> frames_;
+    bool is_key_written_ = false;
+
+    // Разделитель и отступ перед очередным элементом
+    void StartItem();
+    void WriteSeparator();
+    void PrintIndent() const;
+    void PrintNewLine() const;
+    void EndContainer(bool is_dict);
+
+    class BaseContext {
+    public:
+        BaseContext(Writer& writer) : writer_(writer) {}
+        DictValueContext Key(std::string_view key) {
+            return writer_.Key(key);
+        }
+        template <typename T>
+        BaseContext Value(const T& value) {
+            return writer_.Value(value);
+        }
+        DictItemContext StartDict() {
+            return writer_.StartDict();
+        }
+        ArrayItemContext StartArray() {
+            return writer_.StartArray();
+        }
+        BaseContext EndDict() {
+            return writer_.EndDict();
+        }
+        BaseContext EndArray() {
+            return writer_.EndArray();
+        }
+    private:
+        Writer& writer_;
+    };
+
+    class DictValueContext : public BaseContext {
+    public:
+        DictValueContext(BaseContext base) : BaseContext(base) {}
+        template <typename T>
+        DictItemContext Value(const T& value) { return BaseContext::Value(value); }
+        DictValueContext Key(std::string_view key) = delete;
+        BaseContext EndDict() = delete;
+        BaseContext EndArray() = delete;
+    };
+
+    class DictItemContext : public BaseContext {
+    public:
+        DictItemContext(BaseContext base) : BaseContext(base) {}
+        template <typename T>
+        BaseContext Value(const T& value) = delete;
+        BaseContext EndArray() = delete;
+        DictItemContext StartDict() = delete;
+        ArrayItemContext StartArray() = delete;
+    };
+
+    class ArrayItemContext : public BaseContext {
+    public:
+        ArrayItemContext(BaseContext base) : BaseContext(base) {}
+        template <typename T>
+        ArrayItemContext Value(const T& value) { return BaseContext::Value(value); }
+        DictValueContext Key(std::string_view key) = delete;
+        BaseContext EndDict() = delete;
+    };
+};
+
+}  // namespace json
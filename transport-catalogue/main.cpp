@@ -1,19 +1,58 @@
 #include "json_reader.h"
+#include "multi_city_catalogue.h"
+#include "tests.h"
+#include "versioned_catalogue.h"
 
+#include <algorithm>
 #include <fstream>
+#include <iostream>
+#include <memory>
+#include <string_view>
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string_view(argv[1]) == "--test") {
+        tests::RunAll();
+        return 0;
+    }
+
+    // Потоки не синхронизируются с stdio, ответы копятся в крупном буфере и пишутся блоками
+    std::ios_base::sync_with_stdio(false);
+    static char output_buffer[1 << 20];
+    std::cout.rdbuf()->pubsetbuf(output_buffer, sizeof(output_buffer));
 
     {
-    TransportCatalogue catalogue;
-    renderer::MapRenderer renderer;
-    router::RouteBuilder router(catalogue);
+    const std::string input = json::ReadAll(std::cin);
+    const std::vector<std::string> root_keys = json::LoadRootKeys(input);
+
+    // Несколько городов в одном входе: справочники с общим пулом имён
+    if (std::count(root_keys.begin(), root_keys.end(), "cities")){
+        MultiCityCatalogue cities(/* warm_up_router */ false);
+        reader::MultiCityJsonReader json_reader(cities, json::Load(std::string_view(input)));
+        json_reader.PrintStat(std::cout);
+        return 0;
+    }
+
+    // Граф маршрутов строится лениво: запросов Route во входных данных может не быть
+    VersionedCatalogue catalogue(/* warm_up_router */ false);
+    std::unique_ptr<reader::JsonReader> json_reader;
+    catalogue.Update([&json_reader, &input](TransportCatalogue& db, renderer::Settings& render_settings){
+        json_reader = std::make_unique<reader::JsonReader>(db, std::string_view(input));
+        render_settings = json_reader->GetRenderSettings();
+    });
+    // Изменения публикуются следующей версией. При ошибке в них остаётся исходная версия.
+    if (const json::Node* delta = json_reader->GetDeltaRequests()){
+        try {
+            catalogue.Update([delta](TransportCatalogue& db, renderer::Settings&){
+                reader::ApplyDelta(db, *delta);
+            });
+        } catch (const json::schema::SchemaError& error){
+            std::cerr << error.what() << '\n';
+        }
+    }
 
-    RequestHandler handler_(catalogue, renderer, router);
-    reader::JsonReader json_reader(catalogue, handler_, std::cin);
-    renderer.SetContext(json_reader.GetRenderContext());
+    auto version = catalogue.Pin();
     
-    //handler_.RenderMap().Render(std::cout);
-    json_reader.PrintStat(std::cout);
+    //version->handler.RenderMap().Render(std::cout);
+    json_reader->PrintStat(version->handler, std::cout);
     }
 }
\ No newline at end of file
@@ -1,39 +1,57 @@
 #include "map_renderer.h"
 
+#include <sstream>
+
 using namespace renderer;
 
 bool renderer::IsZero(double value) {
     return std::abs(value) < EPSILON;
 }
 
-MapRenderer::MapRenderer() = default;
-MapRenderer::MapRenderer(const RenderContext& data)
-:data_(data){
-}
-
-void MapRenderer::SetContext(const RenderContext& data){
-    data_ = data;
-    std::sort(data_.buses_to_draw.begin(), data_.buses_to_draw.end(),
-                                    [](BusPtr lhs, BusPtr rhs){return lhs->name < rhs->name;});
+MapRenderer::MapRenderer(const FrozenCatalogue& db, const Settings& settings)
+: db_(db)
+, settings_(settings){
 }
 
 void MapRenderer::RenderTo(svg::Document& document) const {
     auto all_points = GetAllGeoPoints();
     SphereProjector projector{all_points.begin(), all_points.end(),
-                                data_.render_settings.width_, 
-                                data_.render_settings.height_,
-                                data_.render_settings.padding_};
+                                settings_.width_, 
+                                settings_.height_,
+                                settings_.padding_};
     AddLines(document, projector);
     AddBusNames(document, projector);
     AddStopCircles(document, projector);
     AddStopNames(document, projector);
 }
 
+const std::string& MapRenderer::GetRenderedMap() const {
+    std::call_once(map_flag_, [this]{
+        svg::Document document;
+        RenderTo(document);
+        std::ostringstream stream;
+        document.Render(stream);
+        rendered_map_ = stream.str();
+        document_usage_ = document.GetMemoryUsage();
+        is_rendered_ = true;
+    });
+    return rendered_map_;
+}
+
+memory::Report MapRenderer::GetMemoryUsage() const {
+    if (!is_rendered_){
+        return {{"svg_document", {}}, {"rendered_map", {}}};
+    }
+    return {{"svg_document", document_usage_},
+            {"rendered_map", {memory::StringBytes(rendered_map_), rendered_map_.size()}}};
+}
+
 void MapRenderer::AddLines(svg::Document& document, SphereProjector& projector) const {
     size_t color_index = 0;
-    size_t over_index = data_.render_settings.color_palette_.size();
-    for (auto bus : data_.buses_to_draw){
-        if (bus->route.empty()){
+    size_t over_index = settings_.color_palette_.size();
+    for (BusId bus = 0; bus < db_.GetBusCount(); ++bus){
+        auto route = db_.GetBusRoute(bus);
+        if (route.begin() == route.end()){
             continue;
         }
         if (color_index == over_index){
@@ -46,21 +64,22 @@ void MapRenderer::AddLines(svg::Document& document, SphereProjector& projector)
 
 void MapRenderer::AddBusNames(svg::Document& document, SphereProjector& projector) const {
     size_t color_index = 0;
-    size_t over_index = data_.render_settings.color_palette_.size();
-    for (auto bus : data_.buses_to_draw){
-        auto edge_stops = bus->edge_stops;
-        if (edge_stops.empty()){
+    size_t over_index = settings_.color_palette_.size();
+    for (BusId bus = 0; bus < db_.GetBusCount(); ++bus){
+        auto route = db_.GetBusRoute(bus);
+        if (route.begin() == route.end()){
             continue;
         }
         if (color_index == over_index){
             color_index = 0;
         }
-        std::string_view bus_name = bus->name;
-        svg::Point route_begin = projector(edge_stops.front()->coordinates);
+        auto [first_stop, last_stop] = db_.GetBusEdgeStops(bus);
+        std::string_view bus_name = db_.GetBusName(bus);
+        svg::Point route_begin = projector(db_.GetStopCoordinates(first_stop));
         document.Add(MakeBusUnderlayer(bus_name, route_begin));
         document.Add(MakeBusName(bus_name, route_begin, color_index));
-        if (edge_stops.front() != edge_stops.back()){
-            svg::Point route_end = projector(edge_stops.back()->coordinates);
+        if (first_stop != last_stop){
+            svg::Point route_end = projector(db_.GetStopCoordinates(last_stop));
             document.Add(MakeBusUnderlayer(bus_name, route_end));
             document.Add(MakeBusName(bus_name, route_end, color_index));
         }
@@ -69,34 +88,40 @@ void MapRenderer::AddBusNames(svg::Document& document, SphereProjector& projecto
 }
 
 void MapRenderer::AddStopCircles(svg::Document& document, SphereProjector& projector) const {
-    for (auto stop : data_.all_stops){
-        svg::Point center = projector(stop->coordinates);
+    for (StopId stop = 0; stop < db_.GetStopCount(); ++stop){
+        if (!IsStopOnRoutes(stop)){
+            continue;
+        }
+        svg::Point center = projector(db_.GetStopCoordinates(stop));
         document.Add(MakeStopCircle(center));
     }
 }
 
 void MapRenderer::AddStopNames(svg::Document& document, SphereProjector& projector) const {
-    for (auto stop : data_.all_stops){
-        svg::Point point = projector(stop->coordinates);
-        document.Add(MakeStopUnderlayer(stop->name, point));
-        document.Add(MakeStopName(stop->name, point));
+    for (StopId stop = 0; stop < db_.GetStopCount(); ++stop){
+        if (!IsStopOnRoutes(stop)){
+            continue;
+        }
+        svg::Point point = projector(db_.GetStopCoordinates(stop));
+        document.Add(MakeStopUnderlayer(db_.GetStopName(stop), point));
+        document.Add(MakeStopName(db_.GetStopName(stop), point));
     }
 }
 
 
 
 
-svg::Polyline MapRenderer::MakeRoute(BusPtr bus_ptr, SphereProjector& projector, size_t color_index) const {
+svg::Polyline MapRenderer::MakeRoute(BusId bus, SphereProjector& projector, size_t color_index) const {
     svg::Polyline line;
-    for (auto stop : bus_ptr->route){
-        line.AddPoint(projector(stop->coordinates));
+    for (StopId stop : db_.GetBusRoute(bus)){
+        line.AddPoint(projector(db_.GetStopCoordinates(stop)));
     }
 
     line.SetStrokeLineCap(svg::StrokeLineCap::ROUND)
          .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND)
-         .SetStrokeColor(data_.render_settings.color_palette_.at(color_index++))
+         .SetStrokeColor(settings_.color_palette_.at(color_index++))
          .SetFillColor(svg::NoneColor)
-         .SetStrokeWidth(data_.render_settings.line_width_);
+         .SetStrokeWidth(settings_.line_width_);
     
     return line;
 }
@@ -106,13 +131,13 @@ svg::Text MapRenderer::MakeBusUnderlayer(sv bus_name, svg::Point point) const {
 
     text.SetPosition(point)
         .SetData(std::string(bus_name))
-        .SetOffset({data_.render_settings.bus_label_offset_x_, data_.render_settings.bus_label_offset_y_})
-        .SetFontSize(static_cast<uint32_t>(data_.render_settings.bus_label_font_size_))
+        .SetOffset({settings_.bus_label_offset_x_, settings_.bus_label_offset_y_})
+        .SetFontSize(static_cast<uint32_t>(settings_.bus_label_font_size_))
         .SetFontFamily("Verdana")
         .SetFontWeight("bold")
-        .SetFillColor(data_.render_settings.underlayer_color_)
-        .SetStrokeColor(data_.render_settings.underlayer_color_)
-        .SetStrokeWidth(data_.render_settings.underlayer_width_)
+        .SetFillColor(settings_.underlayer_color_)
+        .SetStrokeColor(settings_.underlayer_color_)
+        .SetStrokeWidth(settings_.underlayer_width_)
         .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
         .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
     return text;
@@ -123,18 +148,18 @@ svg::Text MapRenderer::MakeBusName(sv bus_name, svg::Point point, size_t color_i
 
     text.SetPosition(point)
         .SetData(std::string(bus_name))
-        .SetOffset({data_.render_settings.bus_label_offset_x_, data_.render_settings.bus_label_offset_y_})
-        .SetFontSize(static_cast<uint32_t>(data_.render_settings.bus_label_font_size_))
+        .SetOffset({settings_.bus_label_offset_x_, settings_.bus_label_offset_y_})
+        .SetFontSize(static_cast<uint32_t>(settings_.bus_label_font_size_))
         .SetFontFamily("Verdana")
         .SetFontWeight("bold")
-        .SetFillColor(data_.render_settings.color_palette_.at(color_index));
+        .SetFillColor(settings_.color_palette_.at(color_index));
     return text;
 }
 
 svg::Circle MapRenderer::MakeStopCircle(svg::Point center) const {
     svg::Circle circle;
     circle.SetCenter(center)
-          .SetRadius(data_.render_settings.stop_radius_)
+          .SetRadius(settings_.stop_radius_)
           .SetFillColor("white");
     return circle;
 }
@@ -143,12 +168,12 @@ svg::Text MapRenderer::MakeStopUnderlayer(sv stop_name, svg::Point point) const
 
     text.SetData(std::string(stop_name))
         .SetPosition(point)
-        .SetOffset({data_.render_settings.stop_label_offset_x_, data_.render_settings.stop_label_offset_y_})
-        .SetFontSize(static_cast<uint32_t>(data_.render_settings.stop_label_font_size_))
+        .SetOffset({settings_.stop_label_offset_x_, settings_.stop_label_offset_y_})
+        .SetFontSize(static_cast<uint32_t>(settings_.stop_label_font_size_))
         .SetFontFamily("Verdana")
-        .SetFillColor(data_.render_settings.underlayer_color_)
-        .SetStrokeColor(data_.render_settings.underlayer_color_)
-        .SetStrokeWidth(data_.render_settings.underlayer_width_)
+        .SetFillColor(settings_.underlayer_color_)
+        .SetStrokeColor(settings_.underlayer_color_)
+        .SetStrokeWidth(settings_.underlayer_width_)
         .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
         .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
 
@@ -159,8 +184,8 @@ svg::Text MapRenderer::MakeStopName(sv stop_name, svg::Point point) const {
 
     text.SetData(std::string(stop_name))
         .SetPosition(point)
-        .SetOffset({data_.render_settings.stop_label_offset_x_, data_.render_settings.stop_label_offset_y_})
-        .SetFontSize(static_cast<uint32_t>(data_.render_settings.stop_label_font_size_))
+        .SetOffset({settings_.stop_label_offset_x_, settings_.stop_label_offset_y_})
+        .SetFontSize(static_cast<uint32_t>(settings_.stop_label_font_size_))
         .SetFontFamily("Verdana")
         .SetFillColor("black");
 
@@ -169,8 +194,16 @@ svg::Text MapRenderer::MakeStopName(sv stop_name, svg::Point point) const {
 
 std::vector<geo::Coordinates> MapRenderer::GetAllGeoPoints() const {
     std::vector<geo::Coordinates> result;
-    for (auto stop : data_.all_stops){
-        result.emplace_back(stop->coordinates);
+    for (StopId stop = 0; stop < db_.GetStopCount(); ++stop){
+        if (IsStopOnRoutes(stop)){
+            result.emplace_back(db_.GetStopCoordinates(stop));
+        }
     }
     return result;
 }
+
+// На карте рисуются только остановки, через которые проходит хотя бы один автобус
+bool MapRenderer::IsStopOnRoutes(StopId stop) const {
+    auto buses = db_.GetBusesByStop(stop);
+    return buses.begin() != buses.end();
+}
@@ -1,10 +1,13 @@
 #pragma once
 
-#include "domain.h"
+#include "frozen_catalogue.h"
 #include "geo.h"
 #include "svg.h"
 
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
 
 namespace renderer{
 
@@ -31,12 +34,6 @@ struct Settings {
     std::vector<svg::Color> color_palette_;
 };
 
-struct RenderContext{
-    renderer::Settings render_settings;
-    std::vector<StopPtr> all_stops;
-    std::vector<BusPtr> buses_to_draw;
-};
-
 inline const double EPSILON = 1e-6;
 bool IsZero(double value);
 
@@ -111,27 +108,39 @@ private:
 class MapRenderer{
 public:
 
-    MapRenderer();
-    MapRenderer(const RenderContext& data);
-
-    void SetContext(const RenderContext& data);
+    MapRenderer(const FrozenCatalogue& db, const Settings& settings);
 
     void RenderTo(svg::Document& document) const;
 
+    // SVG- .        .
+    const std::string& GetRenderedMap() const;
+
+    //  SVG-        .
+    //       .
+    memory::Report GetMemoryUsage() const;
+
 private:
     void AddLines(svg::Document& document, SphereProjector& projector) const;
     void AddBusNames(svg::Document& document, SphereProjector& projector) const;
     void AddStopCircles(svg::Document& document, SphereProjector& projector) const;
     void AddStopNames(svg::Document& document, SphereProjector& projector) const;
 
-    svg::Polyline MakeRoute(BusPtr bus, SphereProjector& projector, size_t color_index) const;
+    svg::Polyline MakeRoute(BusId bus, SphereProjector& projector, size_t color_index) const;
     svg::Text MakeBusUnderlayer(sv bus_name, svg::Point point) const;
     svg::Text MakeBusName(sv bus_name, svg::Point point, size_t color_index) const;
     svg::Circle MakeStopCircle(svg::Point center) const;
     svg::Text MakeStopUnderlayer(sv stop_name, svg::Point point) const;
     svg::Text MakeStopName(sv stop_name, svg::Point point) const;
     std::vector<geo::Coordinates> GetAllGeoPoints() const;
-    RenderContext data_;
+    bool IsStopOnRoutes(StopId stop) const;
+
+    const FrozenCatalogue& db_;
+    Settings settings_;
+
+    mutable std::once_flag map_flag_;
+    mutable std::string rendered_map_;
+    mutable memory::Usage document_usage_;
+    mutable std::atomic<bool> is_rendered_ = false;
 };
 
 }// namespace renderer
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Приблизительный учёт памяти структур данных. Считается память в куче,
+// которой владеет объект; размер самого объекта не учитывается.
+// Накладные расходы узлов контейнеров оцениваются по устройству libstdc++.
+namespace memory {
+
+struct Usage {
+    size_t bytes = 0;
+    size_t count = 0;
+
+    Usage& operator+=(const Usage& other) {
+        bytes += other.bytes;
+        count += other.count;
+        return *this;
+    }
+};
+
+// Составляющие подсистемы в порядке перечисления
+using Report = std::vector<std::pair<std::string, Usage>>;
+
+template <typename T>
+size_t VectorBytes(const std::vector<T>& container) {
+    return container.capacity() * sizeof(T);
+}
+
+// Элементы std::vector<bool> упакованы по битам
+inline size_t VectorBytes(const std::vector<bool>& container) {
+    return (container.capacity() + 7) / 8;
+}
+
+inline size_t StringBytes(const std::string& str) {
+    // Короткие строки хранятся внутри объекта и отдельной памяти не занимают
+    static const size_t inplace_capacity = std::string().capacity();
+    return str.capacity() > inplace_capacity ? str.capacity() + 1 : 0;
+}
+
+template <typename T>
+size_t DequeBytes(const std::deque<T>& container) {
+    return container.size() * sizeof(T);
+}
+
+// Узел хеш-таблицы: значение, указатель на следующий узел и сохранённый хеш
+template <typename HashTable>
+size_t HashTableBytes(const HashTable& table) {
+    return table.bucket_count() * sizeof(void*)
+        + table.size() * (sizeof(typename HashTable::value_type) + 2 * sizeof(void*));
+}
+
+// Узел красно-чёрного дерева: значение, три указателя и цвет
+template <typename Tree>
+size_t TreeBytes(const Tree& tree) {
+    return tree.size() * (sizeof(typename Tree::value_type) + 4 * sizeof(void*));
+}
+
+}  // namespace memory
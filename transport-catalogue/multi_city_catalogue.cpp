@@ -0,0 +1,38 @@
+#include "multi_city_catalogue.h"
+
+using namespace std;
+
+MultiCityCatalogue::MultiCityCatalogue(bool warm_up_router)
+: warm_up_router_(warm_up_router)
+, names_(make_shared<StringPool>()){
+}
+
+VersionedCatalogue& MultiCityCatalogue::AddCity(string_view name){
+    lock_guard guard(cities_mutex_);
+    auto it = cities_.find(name);
+    if (it == cities_.end()){
+        it = cities_.emplace(string(name), make_unique<VersionedCatalogue>(warm_up_router_, names_)).first;
+    }
+    return *it->second;
+}
+
+VersionedCatalogue* MultiCityCatalogue::FindCity(string_view name){
+    lock_guard guard(cities_mutex_);
+    auto it = cities_.find(name);
+    return it == cities_.end() ? nullptr : it->second.get();
+}
+
+const VersionedCatalogue* MultiCityCatalogue::FindCity(string_view name) const {
+    lock_guard guard(cities_mutex_);
+    auto it = cities_.find(name);
+    return it == cities_.end() ? nullptr : it->second.get();
+}
+
+size_t MultiCityCatalogue::GetCityCount() const {
+    lock_guard guard(cities_mutex_);
+    return cities_.size();
+}
+
+const StringPool& MultiCityCatalogue::GetNames() const {
+    return *names_;
+}
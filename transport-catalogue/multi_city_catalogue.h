@@ -0,0 +1,38 @@
+#pragma once
+
+#include "string_pool.h"
+#include "versioned_catalogue.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+// Справочники нескольких городов в одном процессе. Имена остановок и автобусов
+// всех городов хранятся в одном пуле, поэтому общие для городов имена не дублируются.
+// Каждый город обновляется и публикует версии независимо от остальных.
+class MultiCityCatalogue {
+public:
+    explicit MultiCityCatalogue(bool warm_up_router = true);
+
+    // Возвращает справочник города, создавая его при первом обращении
+    VersionedCatalogue& AddCity(std::string_view name);
+
+    // Справочник города или nullptr, если такого города нет
+    VersionedCatalogue* FindCity(std::string_view name);
+    const VersionedCatalogue* FindCity(std::string_view name) const;
+
+    size_t GetCityCount() const;
+
+    const StringPool& GetNames() const;
+
+private:
+    bool warm_up_router_;
+    std::shared_ptr<StringPool> names_;
+
+    // Справочники городов не перемещаются: ссылки на них действительны всё время жизни контейнера
+    mutable std::mutex cities_mutex_;
+    std::map<std::string, std::unique_ptr<VersionedCatalogue>, std::less<>> cities_;
+};
@@ -0,0 +1,131 @@
+#include "perfect_hash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+const size_t keys_per_bucket = 4;
+const int max_attempts = 32;
+
+// Финализатор splitmix64
+uint64_t Mix(uint64_t value) {
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+}  // namespace
+
+PerfectHash::PerfectHash(const vector<string_view>& keys) {
+    if (keys.empty()) {
+        return;
+    }
+    vector<uint64_t> hashes(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        hashes[i] = Hash(keys[i]);
+    }
+    const size_t bucket_count = max<size_t>(1, keys.size() / keys_per_bucket);
+
+    for (int attempt = 0; attempt < max_attempts; ++attempt) {
+        seed_ = Mix(attempt);
+        displacements_.assign(bucket_count, 0);
+
+        vector<vector<uint32_t>> buckets(bucket_count);
+        for (uint32_t i = 0; i < keys.size(); ++i) {
+            auto& bucket = buckets[GetBucket(hashes[i])];
+            bool is_duplicate = any_of(bucket.begin(), bucket.end(),
+                [&](uint32_t other){ return hashes[other] == hashes[i] && keys[other] == keys[i]; });
+            if (!is_duplicate) {
+                bucket.push_back(i);
+            }
+        }
+        size_t unique_count = 0;
+        vector<uint32_t> order(bucket_count);
+        for (uint32_t i = 0; i < bucket_count; ++i) {
+            unique_count += buckets[i].size();
+            order[i] = i;
+        }
+        // Крупные корзины размещаются первыми, пока таблица почти пуста
+        stable_sort(order.begin(), order.end(),
+            [&buckets](uint32_t lhs, uint32_t rhs){ return buckets[lhs].size() > buckets[rhs].size(); });
+
+        const uint32_t free_slot = static_cast<uint32_t>(keys.size());
+        slots_.assign(unique_count, free_slot);
+        const uint64_t max_displacement = 64 * static_cast<uint64_t>(unique_count) + 1024;
+        vector<uint32_t> candidate;
+        bool is_placed = true;
+
+        for (uint32_t bucket_index : order) {
+            const auto& bucket = buckets[bucket_index];
+            if (bucket.empty()) {
+                break;
+            }
+            is_placed = false;
+            for (uint32_t displacement = 0; displacement < max_displacement && !is_placed; ++displacement) {
+                candidate.clear();
+                for (uint32_t key : bucket) {
+                    uint32_t slot = GetSlot(hashes[key], displacement);
+                    if (slots_[slot] != free_slot
+                        || find(candidate.begin(), candidate.end(), slot) != candidate.end()) {
+                        break;
+                    }
+                    candidate.push_back(slot);
+                }
+                if (candidate.size() == bucket.size()) {
+                    for (size_t i = 0; i < bucket.size(); ++i) {
+                        slots_[candidate[i]] = bucket[i];
+                    }
+                    displacements_[bucket_index] = displacement;
+                    is_placed = true;
+                }
+            }
+            if (!is_placed) {
+                break;
+            }
+        }
+        if (is_placed) {
+            return;
+        }
+    }
+    throw runtime_error("Failed to build perfect hash");
+}
+
+uint32_t PerfectHash::operator()(string_view key) const {
+    const uint64_t hash = Hash(key);
+    return slots_[GetSlot(hash, displacements_[GetBucket(hash)])];
+}
+
+bool PerfectHash::Empty() const {
+    return slots_.empty();
+}
+
+memory::Usage PerfectHash::GetMemoryUsage() const {
+    return {memory::VectorBytes(displacements_) + memory::VectorBytes(slots_), slots_.size()};
+}
+
+// Строка читается по 8 байт. Результат одинаков на любой платформе с порядком байтов little-endian.
+uint64_t PerfectHash::Hash(string_view key) {
+    uint64_t hash = 0xcbf29ce484222325ULL ^ key.size();
+    size_t pos = 0;
+    for (; pos + 8 <= key.size(); pos += 8) {
+        uint64_t chunk;
+        memcpy(&chunk, key.data() + pos, 8);
+        hash = Mix(hash ^ chunk);
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, key.data() + pos, key.size() - pos);
+    return Mix(hash ^ tail);
+}
+
+uint32_t PerfectHash::GetBucket(uint64_t hash) const {
+    return static_cast<uint32_t>(Mix(hash ^ seed_) % displacements_.size());
+}
+
+uint32_t PerfectHash::GetSlot(uint64_t hash, uint32_t displacement) const {
+    return static_cast<uint32_t>(Mix(hash + displacement * 0x9e3779b97f4a7c15ULL) % slots_.size());
+}
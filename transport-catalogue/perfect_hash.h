@@ -0,0 +1,40 @@
+#pragma once
+
+#include "memory_usage.h"
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Минимальная совершенная хеш-функция над заранее известным набором строк (схема CHD).
+// Ключи раскладываются по корзинам, для каждой корзины подбирается смещение,
+// при котором её ключи попадают в свободные слоты таблицы размером ровно в число ключей.
+// Поиск — один хеш строки и два обращения к массивам. Состояние — плоские массивы
+// целых чисел, а хеш не зависит от реализации стандартной библиотеки,
+// поэтому таблицу можно сохранять на диск вместе со снимком.
+class PerfectHash {
+public:
+    PerfectHash() = default;
+
+    // Повторяющиеся ключи учитываются один раз, за ключом закрепляется первое вхождение
+    explicit PerfectHash(const std::vector<std::string_view>& keys);
+
+    // Номер ключа в наборе, переданном в конструктор. Для строки не из набора
+    // возвращается номер какого-то другого ключа, поэтому результат нужно сверить с ключом.
+    // Для пустого набора вызывать нельзя.
+    uint32_t operator()(std::string_view key) const;
+
+    bool Empty() const;
+
+    memory::Usage GetMemoryUsage() const;
+
+    static uint64_t Hash(std::string_view key);
+
+private:
+    uint32_t GetBucket(uint64_t hash) const;
+    uint32_t GetSlot(uint64_t hash, uint32_t displacement) const;
+
+    uint64_t seed_ = 0;
+    std::vector<uint32_t> displacements_;
+    std::vector<uint32_t> slots_;
+};
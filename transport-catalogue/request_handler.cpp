@@ -1,34 +1,86 @@
 #include "request_handler.h"
 
-RequestHandler::RequestHandler(const TransportCatalogue& db, const renderer::MapRenderer& renderer, const router::RouteBuilder& router)
+#include <algorithm>
+
+RequestHandler::RequestHandler(const FrozenCatalogue& db, const renderer::MapRenderer& renderer, const router::RouteBuilder& router,
+                               const memory::Report& source_memory)
 : db_(db)
 , renderer_(renderer)
-, router_(router){
+, router_(router)
+, source_memory_(source_memory){
 }
 
 std::optional<BusInfo> RequestHandler::GetBusStat(const std::string_view& bus_name) const {
-    auto ptr = db_.GetBusInfo(bus_name);
-    if(ptr){
-        return *ptr;
+    auto id = db_.FindBus(bus_name);
+    if(id){
+        return db_.GetBusInfo(*id);
     }
     return std::nullopt;
 };
 
-const std::set<sv>* RequestHandler::GetBusesByStop(const std::string_view& stop_name) const {
-    auto ptr = db_.GetStopInfo(stop_name);
-    if (ptr){
-        return &ptr->through_buses;
+std::optional<FrozenCatalogue::BusRange> RequestHandler::GetBusesByStop(const std::string_view& stop_name) const {
+    auto id = db_.FindStop(stop_name);
+    if (id){
+        return db_.GetBusesByStop(*id);
+    }
+    return std::nullopt;
+}
+
+std::optional<std::vector<BusId>> RequestHandler::GetCommonBuses(const std::vector<std::string_view>& stop_names) const {
+    std::vector<StopId> stops;
+    stops.reserve(stop_names.size());
+    for (std::string_view name : stop_names){
+        auto stop = db_.FindStop(name);
+        if (!stop){
+            return std::nullopt;
+        }
+        stops.push_back(*stop);
     }
-    return nullptr;
+    return db_.FindCommonBuses(stops);
+}
+
+std::string_view RequestHandler::GetBusName(BusId bus) const {
+    return db_.GetBusName(bus);
+}
+
+std::string_view RequestHandler::GetStopName(StopId stop) const {
+    return db_.GetStopName(stop);
+}
+
+std::vector<geo::Neighbour> RequestHandler::GetNearestStops(geo::Coordinates point, size_t count) const {
+    return db_.FindNearestStops(point, count);
+}
+
+std::vector<geo::Neighbour> RequestHandler::GetStopsInRadius(geo::Coordinates point, double radius) const {
+    return db_.FindStopsInRadius(point, radius);
+}
+
+std::vector<StopId> RequestHandler::GetStopsInBox(geo::Coordinates min, geo::Coordinates max) const {
+    return db_.FindStopsInBox(min, max);
+}
+
+std::pair<StopId, StopId> RequestHandler::GetStopsByPrefix(std::string_view prefix, size_t count) const {
+    auto [first, last] = db_.FindStopsByPrefix(prefix);
+    return {first, static_cast<StopId>(std::min<size_t>(last, first + count))};
+}
+
+std::pair<BusId, BusId> RequestHandler::GetBusesByPrefix(std::string_view prefix, size_t count) const {
+    auto [first, last] = db_.FindBusesByPrefix(prefix);
+    return {first, static_cast<BusId>(std::min<size_t>(last, first + count))};
 }
 
 std::optional<router::Way> RequestHandler::GetBestWay(const std::string_view& stop_name_from,
                                         const std::string_view& stop_name_to) const {
-    if (!router_.IsReadyToBuild()){
-        router_.InitializeGraph();
+    auto from = db_.FindStop(stop_name_from);
+    auto to = db_.FindStop(stop_name_to);
+    if (!from || !to){
+        return std::nullopt;
     }
-    return router_.GetBestWay(db_.GetStop(stop_name_from),
-                              db_.GetStop(stop_name_to));
+    return router_.GetBestWay(*from, *to);
+}
+
+std::optional<router::Way> RequestHandler::GetBestJourney(geo::Coordinates from, geo::Coordinates to) const {
+    return router_.GetBestJourney(from, to);
 }
 
 svg::Document RequestHandler::RenderMap() const {
@@ -36,4 +88,24 @@ svg::Document RequestHandler::RenderMap() const {
 
     renderer_.RenderTo(result);
     return result;
-}
\ No newline at end of file
+}
+
+const std::string& RequestHandler::GetRenderedMap() const {
+    return renderer_.GetRenderedMap();
+}
+
+memory::Report RequestHandler::GetCatalogueMemoryUsage() const {
+    return db_.GetMemoryUsage();
+}
+
+memory::Report RequestHandler::GetRouterMemoryUsage() const {
+    return router_.GetMemoryUsage();
+}
+
+memory::Report RequestHandler::GetMapMemoryUsage() const {
+    return renderer_.GetMemoryUsage();
+}
+
+const memory::Report& RequestHandler::GetSourceMemoryUsage() const {
+    return source_memory_;
+}
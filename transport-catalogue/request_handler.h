@@ -1,29 +1,68 @@
 #pragma once
 
+#include "frozen_catalogue.h"
 #include "map_renderer.h"
 #include "svg.h"
-#include "transport_catalogue.h"
 #include "transport_router.h"
 #include <memory>
 
 class RequestHandler {
 public:
-    RequestHandler(const TransportCatalogue& db, const renderer::MapRenderer& renderer, const router::RouteBuilder& router);
+    // source_memory — память изменяемого справочника, из которого построен снимок
+    RequestHandler(const FrozenCatalogue& db, const renderer::MapRenderer& renderer, const router::RouteBuilder& router,
+                   const memory::Report& source_memory);
 
     // Возвращает информацию о маршруте (запрос Bus)
     std::optional<BusInfo> GetBusStat(const std::string_view& bus_name) const;
 
     // Возвращает маршруты, проходящие через остановку
-    const std::set<sv>* GetBusesByStop(const std::string_view& stop_name) const;
+    std::optional<FrozenCatalogue::BusRange> GetBusesByStop(const std::string_view& stop_name) const;
+
+    // Возвращает автобусы, проходящие через все остановки. Если какой-то остановки нет — nullopt.
+    std::optional<std::vector<BusId>> GetCommonBuses(const std::vector<std::string_view>& stop_names) const;
+
+    // Возвращает имя автобуса по его номеру в справочнике
+    std::string_view GetBusName(BusId bus) const;
+
+    // Возвращает имя остановки по её номеру в справочнике
+    std::string_view GetStopName(StopId stop) const;
+
+    // Возвращает не более count ближайших к точке остановок
+    std::vector<geo::Neighbour> GetNearestStops(geo::Coordinates point, size_t count) const;
+
+    // Возвращает остановки на расстоянии не более radius метров от точки
+    std::vector<geo::Neighbour> GetStopsInRadius(geo::Coordinates point, double radius) const;
+
+    // Возвращает остановки внутри прямоугольника
+    std::vector<StopId> GetStopsInBox(geo::Coordinates min, geo::Coordinates max) const;
+
+    // Возвращают не более count первых по алфавиту остановок (автобусов),
+    // имена которых начинаются с prefix, как диапазон номеров [first, last)
+    std::pair<StopId, StopId> GetStopsByPrefix(std::string_view prefix, size_t count) const;
+    std::pair<BusId, BusId> GetBusesByPrefix(std::string_view prefix, size_t count) const;
 
     // Возвращает оптимальный маршрут от остановки from до остановки to
     std::optional<router::Way> GetBestWay(const std::string_view& stop_name_from,
                             const std::string_view& stop_name_to) const;
 
+    // Возвращает оптимальный маршрут между точками с пешими участками до остановок и от них
+    std::optional<router::Way> GetBestJourney(geo::Coordinates from, geo::Coordinates to) const;
+
     svg::Document RenderMap() const;
+
+    // Возвращает готовое SVG-представление карты
+    const std::string& GetRenderedMap() const;
+
+    // Возвращают память снимка справочника, маршрутизатора и визуализатора
+    memory::Report GetCatalogueMemoryUsage() const;
+    memory::Report GetRouterMemoryUsage() const;
+    memory::Report GetMapMemoryUsage() const;
+    // Память изменяемого справочника на момент построения снимка
+    const memory::Report& GetSourceMemoryUsage() const;
 private:
     // RequestHandler использует агрегацию объектов "Транспортный Справочник" и "Визуализатор Карты"
-    const TransportCatalogue& db_;
+    const FrozenCatalogue& db_;
     const renderer::MapRenderer& renderer_;
     const router::RouteBuilder& router_;
+    const memory::Report& source_memory_;
 };
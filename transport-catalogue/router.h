@@ -29,6 +29,9 @@ public:
 
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+    // count — число элементов матрицы кратчайших путей
+    memory::Usage GetMemoryUsage() const;
+
 private:
     struct RouteInternalData {
         Weight weight;
@@ -114,4 +117,14 @@ std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(Ver
     return RouteInfo{weight, std::move(edges)};
 }
 
+template <typename Weight>
+memory::Usage Router<Weight>::GetMemoryUsage() const {
+    memory::Usage usage{memory::VectorBytes(routes_internal_data_), 0};
+    for (const auto& row : routes_internal_data_) {
+        usage.bytes += memory::VectorBytes(row);
+        usage.count += row.size();
+    }
+    return usage;
+}
+
 }  // namespace graph
\ No newline at end of file
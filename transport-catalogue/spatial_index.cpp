@@ -0,0 +1,223 @@
+#define _USE_MATH_DEFINES
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace geo {
+
+namespace {
+
+const double meters_per_degree = radius_of_the_earth * M_PI / 180.0;
+const size_t points_per_cell = 4;
+// Оценки размеров ячеек сделаны в равнопромежуточной проекции, запас покрывает её погрешность
+const double bound_slack = 0.95;
+
+double CosOfLatitude(double lat) {
+    return std::cos(std::min(std::abs(lat), 89.0) * M_PI / 180.0);
+}
+
+// Кандидаты сравниваются по квадрату хорды, в расстояние переводятся только отобранные
+bool ByDistance(const Neighbour& lhs, const Neighbour& rhs) {
+    return lhs.distance < rhs.distance
+        || (lhs.distance == rhs.distance && lhs.index < rhs.index);
+}
+
+}  // namespace
+
+GridIndex::GridIndex(const std::vector<Coordinates>& points) {
+    if (points.empty()) {
+        return;
+    }
+    const auto [bottom_it, top_it] = std::minmax_element(points.begin(), points.end(),
+            [](Coordinates lhs, Coordinates rhs) { return lhs.lat < rhs.lat; });
+    const auto [left_it, right_it] = std::minmax_element(points.begin(), points.end(),
+            [](Coordinates lhs, Coordinates rhs) { return lhs.lng < rhs.lng; });
+    min_lat_ = bottom_it->lat;
+    min_lng_ = left_it->lng;
+    const double lat_span = top_it->lat - min_lat_;
+    const double lng_span = right_it->lng - min_lng_;
+
+    // Ячейки примерно квадратные в метрах: градус долготы короче градуса широты в cos(lat) раз
+    const double height = lat_span * meters_per_degree;
+    const double width = lng_span * meters_per_degree * CosOfLatitude((min_lat_ + top_it->lat) / 2);
+    const double cells = std::max<size_t>(1, points.size() / points_per_cell);
+    double cell_size = std::max(height, width) / cells;
+    if (height > 0 && width > 0) {
+        cell_size = std::max(cell_size, std::sqrt(height * width / cells));
+    }
+
+    rows_ = cell_size > 0 ? std::max<size_t>(1, static_cast<size_t>(std::ceil(height / cell_size))) : 1;
+    cols_ = cell_size > 0 ? std::max<size_t>(1, static_cast<size_t>(std::ceil(width / cell_size))) : 1;
+    cell_lat_ = lat_span > 0 ? lat_span / rows_ : 1.0;
+    cell_lng_ = lng_span > 0 ? lng_span / cols_ : 1.0;
+
+    const double min_cos = std::min(CosOfLatitude(min_lat_), CosOfLatitude(top_it->lat));
+    min_cell_size_ = std::min(cell_lat_ * meters_per_degree, cell_lng_ * meters_per_degree * min_cos);
+
+    // Сортировка подсчётом: номера точек группируются по ячейкам
+    std::vector<size_t> point_cells(points.size());
+    cell_offsets_.assign(rows_ * cols_ + 1, 0);
+    for (size_t i = 0; i < points.size(); ++i) {
+        point_cells[i] = GetRow(points[i].lat) * cols_ + GetCol(points[i].lng);
+        ++cell_offsets_[point_cells[i] + 1];
+    }
+    for (size_t cell = 0; cell < rows_ * cols_; ++cell) {
+        max_cell_points_ = std::max<size_t>(max_cell_points_, cell_offsets_[cell + 1]);
+        cell_offsets_[cell + 1] += cell_offsets_[cell];
+    }
+    std::vector<uint32_t> positions(cell_offsets_.begin(), cell_offsets_.end() - 1);
+    points_.resize(points.size());
+    indexes_.resize(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        uint32_t position = positions[point_cells[i]]++;
+        points_[position] = points[i];
+        indexes_[position] = static_cast<uint32_t>(i);
+    }
+    prepared_points_.Reserve(points_.size());
+    for (Coordinates point : points_) {
+        prepared_points_.Add(point);
+    }
+}
+
+std::vector<Neighbour> GridIndex::FindNearest(Coordinates point, size_t count) const {
+    count = std::min(count, points_.size());
+    std::vector<Neighbour> result;
+    if (count == 0) {
+        return result;
+    }
+    result.reserve(count);
+    std::vector<double> buffer(max_cell_points_);
+    const UnitVector origin = ToUnitVector(point);
+
+    // result — максимальная куча лучших найденных точек, distance пока хранит квадрат хорды
+    auto consider = [&result, count](uint32_t index, double chord_squared) {
+        Neighbour candidate{index, chord_squared};
+        if (result.size() < count) {
+            result.push_back(candidate);
+            std::push_heap(result.begin(), result.end(), ByDistance);
+        } else if (ByDistance(candidate, result.front())) {
+            std::pop_heap(result.begin(), result.end(), ByDistance);
+            result.back() = candidate;
+            std::push_heap(result.begin(), result.end(), ByDistance);
+        }
+    };
+
+    // Запрос может лежать севернее или южнее сетки, где градус долготы ещё короче
+    const double min_cell_size = std::min(min_cell_size_,
+                                          cell_lng_ * meters_per_degree * CosOfLatitude(point.lat));
+    const long row = static_cast<long>(GetRow(point.lat));
+    const long col = static_cast<long>(GetCol(point.lng));
+    const long max_ring = static_cast<long>(std::max(rows_, cols_));
+    for (long ring = 0; ring <= max_ring; ++ring) {
+        for (long r = row - ring; r <= row + ring; ++r) {
+            if (r < 0 || r >= static_cast<long>(rows_)) {
+                continue;
+            }
+            // Внутренние строки кольца содержат только две крайние ячейки
+            const long step = (r == row - ring || r == row + ring) ? 1 : std::max(1L, 2 * ring);
+            for (long c = col - ring; c <= col + ring; c += step) {
+                if (c >= 0 && c < static_cast<long>(cols_)) {
+                    VisitCell(r, c, origin, buffer, consider);
+                }
+            }
+        }
+        // Точки за пределами кольца удалены не менее чем на ring целых ячеек
+        if (result.size() == count
+            && ChordSquaredToDistance(result.front().distance) <= ring * min_cell_size * bound_slack) {
+            break;
+        }
+    }
+
+    std::sort_heap(result.begin(), result.end(), ByDistance);
+    for (auto& neighbour : result) {
+        neighbour.distance = ChordSquaredToDistance(neighbour.distance);
+    }
+    return result;
+}
+
+std::vector<Neighbour> GridIndex::FindInRadius(Coordinates point, double radius) const {
+    std::vector<Neighbour> result;
+    if (points_.empty() || radius < 0) {
+        return result;
+    }
+    const double delta_lat = radius / meters_per_degree / bound_slack;
+    const double farthest_lat = std::abs(point.lat) + delta_lat;
+    const double delta_lng = delta_lat / CosOfLatitude(farthest_lat);
+    const double max_chord_squared = DistanceToChordSquared(radius);
+    std::vector<double> buffer(max_cell_points_);
+    const UnitVector origin = ToUnitVector(point);
+
+    CellRange cells = GetCells({point.lat - delta_lat, point.lng - delta_lng},
+                               {point.lat + delta_lat, point.lng + delta_lng});
+    for (size_t row = cells.min_row; row <= cells.max_row; ++row) {
+        for (size_t col = cells.min_col; col <= cells.max_col; ++col) {
+            VisitCell(row, col, origin, buffer, [&result, max_chord_squared](uint32_t index, double chord_squared) {
+                if (chord_squared <= max_chord_squared) {
+                    result.push_back({index, chord_squared});
+                }
+            });
+        }
+    }
+    std::sort(result.begin(), result.end(), ByDistance);
+    for (auto& neighbour : result) {
+        neighbour.distance = ChordSquaredToDistance(neighbour.distance);
+    }
+    return result;
+}
+
+std::vector<uint32_t> GridIndex::FindInBox(Coordinates min, Coordinates max) const {
+    std::vector<uint32_t> result;
+    if (points_.empty() || min.lat > max.lat || min.lng > max.lng) {
+        return result;
+    }
+    CellRange cells = GetCells(min, max);
+    for (size_t row = cells.min_row; row <= cells.max_row; ++row) {
+        for (size_t col = cells.min_col; col <= cells.max_col; ++col) {
+            const size_t cell = row * cols_ + col;
+            for (uint32_t position = cell_offsets_[cell]; position < cell_offsets_[cell + 1]; ++position) {
+                Coordinates coordinates = points_[position];
+                if (coordinates.lat >= min.lat && coordinates.lat <= max.lat
+                    && coordinates.lng >= min.lng && coordinates.lng <= max.lng) {
+                    result.push_back(indexes_[position]);
+                }
+            }
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+memory::Usage GridIndex::GetMemoryUsage() const {
+    return {memory::VectorBytes(cell_offsets_) + memory::VectorBytes(points_)
+                + prepared_points_.GetMemoryUsage().bytes + memory::VectorBytes(indexes_),
+            points_.size()};
+}
+
+size_t GridIndex::GetRow(double lat) const {
+    double row = std::floor((lat - min_lat_) / cell_lat_);
+    return static_cast<size_t>(std::clamp(row, 0.0, static_cast<double>(rows_ - 1)));
+}
+
+size_t GridIndex::GetCol(double lng) const {
+    double col = std::floor((lng - min_lng_) / cell_lng_);
+    return static_cast<size_t>(std::clamp(col, 0.0, static_cast<double>(cols_ - 1)));
+}
+
+GridIndex::CellRange GridIndex::GetCells(Coordinates min, Coordinates max) const {
+    return {GetRow(min.lat), GetRow(max.lat), GetCol(min.lng), GetCol(max.lng)};
+}
+
+template <typename Visitor>
+void GridIndex::VisitCell(size_t row, size_t col, UnitVector origin, std::vector<double>& buffer,
+                          Visitor&& visitor) const {
+    const size_t cell = row * cols_ + col;
+    const size_t first = cell_offsets_[cell];
+    const size_t last = cell_offsets_[cell + 1];
+    prepared_points_.ComputeChordsSquared(origin, first, last, buffer.data());
+    for (size_t position = first; position < last; ++position) {
+        visitor(indexes_[position], buffer[position - first]);
+    }
+}
+
+}  // namespace geo
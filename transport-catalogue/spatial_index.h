@@ -0,0 +1,69 @@
+#pragma once
+
+#include "geo.h"
+#include "memory_usage.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace geo {
+
+struct Neighbour {
+    uint32_t index;
+    double distance;
+};
+
+// Равномерная сетка над точками. Размер ячейки подбирается так, чтобы в среднем
+// на ячейку приходилось несколько точек. Точки хранятся сгруппированными по ячейкам,
+// расстояния до точек ячейки считаются одним пакетом через PreparedPoints.
+class GridIndex {
+public:
+    GridIndex() = default;
+    explicit GridIndex(const std::vector<Coordinates>& points);
+
+    // Не более count ближайших точек в порядке возрастания расстояния
+    std::vector<Neighbour> FindNearest(Coordinates point, size_t count) const;
+
+    // Точки на расстоянии не более radius метров в порядке возрастания расстояния
+    std::vector<Neighbour> FindInRadius(Coordinates point, double radius) const;
+
+    // Номера точек внутри прямоугольника в порядке возрастания
+    std::vector<uint32_t> FindInBox(Coordinates min, Coordinates max) const;
+
+    memory::Usage GetMemoryUsage() const;
+
+private:
+    struct CellRange {
+        size_t min_row;
+        size_t max_row;
+        size_t min_col;
+        size_t max_col;
+    };
+
+    size_t GetRow(double lat) const;
+    size_t GetCol(double lng) const;
+    CellRange GetCells(Coordinates min, Coordinates max) const;
+
+    // Считает квадраты хорд от origin до точек ячейки и передаёт их visitor вместе с номерами точек
+    template <typename Visitor>
+    void VisitCell(size_t row, size_t col, UnitVector origin, std::vector<double>& buffer,
+                   Visitor&& visitor) const;
+
+    double min_lat_ = 0;
+    double min_lng_ = 0;
+    double cell_lat_ = 1;
+    double cell_lng_ = 1;
+    size_t rows_ = 0;
+    size_t cols_ = 0;
+    // Нижняя оценка размера ячейки в метрах для отсечения колец при поиске ближайших
+    double min_cell_size_ = 0;
+
+    std::vector<uint32_t> cell_offsets_;
+    size_t max_cell_points_ = 0;
+    std::vector<Coordinates> points_;
+    PreparedPoints prepared_points_;
+    std::vector<uint32_t> indexes_;
+};
+
+}  // namespace geo
@@ -77,11 +77,11 @@ ostream& StatReader::operator<<(ostream& output, const StopInfo* info){
 
     output << "buses "sv;
     bool is_first = true;
-    for (auto stop : info->through_buses){
+    for (BusPtr bus : info->through_buses){
         if (!is_first){
             output << ' ';
         }
-        output << stop;
+        output << bus->name;
         is_first = false;
     }
 
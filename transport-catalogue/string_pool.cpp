@@ -0,0 +1,39 @@
+#include "string_pool.h"
+
+using namespace std;
+
+string_view StringPool::Intern(string_view str) {
+    lock_guard guard(mutex_);
+    auto it = index_.find(str);
+    if (it != index_.end()) {
+        return *it;
+    }
+    string_view result = strings_.emplace_back(str);
+    index_.insert(result);
+    return result;
+}
+
+string_view StringPool::Intern(string&& str) {
+    lock_guard guard(mutex_);
+    auto it = index_.find(str);
+    if (it != index_.end()) {
+        return *it;
+    }
+    string_view result = strings_.emplace_back(std::move(str));
+    index_.insert(result);
+    return result;
+}
+
+size_t StringPool::Size() const {
+    lock_guard guard(mutex_);
+    return strings_.size();
+}
+
+memory::Usage StringPool::GetMemoryUsage() const {
+    lock_guard guard(mutex_);
+    memory::Usage usage{memory::DequeBytes(strings_) + memory::HashTableBytes(index_), strings_.size()};
+    for (const string& str : strings_) {
+        usage.bytes += memory::StringBytes(str);
+    }
+    return usage;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "memory_usage.h"
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+// Хранилище имён, общее для нескольких справочников. Одинаковые строки хранятся один раз,
+// возвращённые ссылки действительны, пока жив пул. Строки не удаляются, даже если
+// ссылающийся на них объект удалён из справочника. Методы можно вызывать из разных потоков.
+class StringPool {
+public:
+    std::string_view Intern(std::string_view str);
+
+    // Новая строка забирается в пул без копирования
+    std::string_view Intern(std::string&& str);
+
+    size_t Size() const;
+
+    memory::Usage GetMemoryUsage() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::deque<std::string> strings_;
+    std::unordered_set<std::string_view> index_;
+};
@@ -63,6 +63,10 @@ Circle& Circle::SetRadius(double radius) {
     return *this;
 }
 
+size_t Circle::GetAllocatedBytes() const {
+    return sizeof(Circle) + GetAttrsBytes();
+}
+
 void Circle::RenderObject(const RenderContext& context) const {
     auto& out = context.out;
     out << "<circle cx=\""sv << center_.x << "\" cy=\""sv << center_.y << "\" "sv;
@@ -78,6 +82,10 @@ Polyline& Polyline::AddPoint(Point point) {
     return *this;
 }
 
+size_t Polyline::GetAllocatedBytes() const {
+    return sizeof(Polyline) + GetAttrsBytes() + memory::VectorBytes(points_);
+}
+
 void Polyline::RenderObject(const RenderContext& context) const {
     auto& out = context.out;
     out << "<polyline points=\""sv;
@@ -127,6 +135,11 @@ Text& Text::SetData(std::string data) {
     return *this;
 }
 
+size_t Text::GetAllocatedBytes() const {
+    return sizeof(Text) + GetAttrsBytes() + memory::StringBytes(font_family_)
+        + memory::StringBytes(font_weight_) + memory::StringBytes(data_);
+}
+
 void Text::RenderObject(const RenderContext& context) const {
     auto& out = context.out;
     out << "<text "sv;
@@ -164,6 +177,14 @@ void Document::Render(std::ostream& out) const {
     out << "</svg>"sv;
 }
 
+memory::Usage Document::GetMemoryUsage() const {
+    memory::Usage usage{memory::VectorBytes(objects_), objects_.size()};
+    for (const auto& obj : objects_) {
+        usage.bytes += obj->GetAllocatedBytes();
+    }
+    return usage;
+}
+
 namespace detail {
 
 void HtmlEncodeString(std::ostream& out, std::string_view sv) {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "memory_usage.h"
+
 #include <cstdint>
 #include <iostream>
 #include <memory>
@@ -94,6 +96,9 @@ class Object {
 public:
     void Render(const RenderContext& context) const;
 
+    // Память объекта вместе с его данными в куче
+    virtual size_t GetAllocatedBytes() const = 0;
+
     virtual ~Object() = default;
 
 private:
@@ -155,6 +160,11 @@ protected:
         RenderOptionalAttr(out, " stroke-linejoin"sv, stroke_line_join_);
     }
 
+    size_t GetAttrsBytes() const {
+        return (fill_color_ ? memory::StringBytes(*fill_color_) : 0)
+            + (stroke_color_ ? memory::StringBytes(*stroke_color_) : 0);
+    }
+
 private:
     Owner& AsOwner() {
         // static_cast безопасно преобразует *this к Owner&,
@@ -180,6 +190,8 @@ public:
     Circle& SetCenter(Point center);
     Circle& SetRadius(double radius);
 
+    size_t GetAllocatedBytes() const override;
+
 private:
     void RenderObject(const RenderContext& context) const override;
 
@@ -196,6 +208,8 @@ public:
     // Добавляет очередную вершину к ломаной линии
     Polyline& AddPoint(Point point);
 
+    size_t GetAllocatedBytes() const override;
+
 private:
     void RenderObject(const RenderContext& context) const override;
     std::vector<Point> points_;
@@ -225,6 +239,8 @@ public:
     // Задаёт текстовое содержимое объекта (отображается внутри тэга text)
     Text& SetData(std::string data);
 
+    size_t GetAllocatedBytes() const override;
+
 private:
     void RenderObject(const RenderContext& context) const override;
     Point position_;
@@ -275,6 +291,9 @@ public:
     // Выводит в ostream svg-представление документа
     void Render(std::ostream& out) const;
 
+    // count — число объектов документа
+    memory::Usage GetMemoryUsage() const;
+
 private:
     std::vector<std::unique_ptr<Object>> objects_;
 };
@@ -1,6 +1,898 @@
 #pragma once
 
+#include "frozen_catalogue.h"
+#include "json_arena.h"
 #include "json_reader.h"
+#include "multi_city_catalogue.h"
+#include "perfect_hash.h"
+#include "spatial_index.h"
+#include "versioned_catalogue.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <iterator>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 
+// Модульные тесты. Запускаются командой transport_catalogue --test
+namespace tests {
+
+// Исключение в updater не оставляет следов ни в текущей, ни в следующей версии
+inline void TestUpdateRollback(){
+    VersionedCatalogue catalogue(/* warm_up_router */ false);
+    catalogue.Update([](TransportCatalogue& db, renderer::Settings&){
+        db.AddStop(std::string_view("A"), {55.6, 37.6});
+    });
+    const uint64_t number = catalogue.Pin()->number;
+
+    bool thrown = false;
+    try {
+        catalogue.Update([](TransportCatalogue& db, renderer::Settings& render_settings){
+            db.AddStop(std::string_view("B"), {55.7, 37.7});
+            render_settings.width_ = 100;
+            throw std::runtime_error("failed update");
+        });
+    } catch (const std::runtime_error&){
+        thrown = true;
+    }
+    assert(thrown);
+    assert(catalogue.Pin()->number == number);
+    assert(!catalogue.Pin()->catalogue->FindStop("B"));
+
+    catalogue.Update([](TransportCatalogue& db, renderer::Settings& render_settings){
+        assert(db.GetStop("B") == nullptr);
+        assert(render_settings.width_ == 0);
+        db.AddStop(std::string_view("C"), {55.8, 37.8});
+    });
+    auto version = catalogue.Pin();
+    assert(version->number == number + 1);
+    assert(version->catalogue->GetStopCount() == 2);
+    assert(version->catalogue->FindStop("A") && version->catalogue->FindStop("C"));
+    assert(!version->catalogue->FindStop("B"));
+}
+
+// Копия справочника не ссылается на объекты оригинала
+inline void TestCatalogueCopy(){
+    TransportCatalogue db;
+    StopPtr a = db.AddStop(std::string_view("A"), {55.6, 37.6});
+    StopPtr b = db.AddStop(std::string_view("B"), {55.61, 37.61});
+    db.AddDistance(a, b, 1500);
+    db.AddBus("1", {a, b}, false);
+    db.Finalize();
+
+    TransportCatalogue copy(db);
+    db.RemoveBus("1");
+    db.RemoveStop("A");
+
+    StopPtr copy_a = copy.GetStop("A");
+    StopPtr copy_b = copy.GetStop("B");
+    assert(copy_a != nullptr && copy_a != a);
+    assert(copy.GetDistance(copy_a, copy_b).road == 1500);
+    assert(copy.GetDistance(copy_b, copy_a).road == 1500);
+    const Bus* bus = copy.GetBus("1");
+    assert(bus != nullptr && bus->stops.front() == copy_a);
+    assert(copy.GetStopInfo("B")->through_buses.front() == bus);
+    assert(copy.GetBusInfo("1")->route_length == 3000);
+}
+
+// Пакетный расчёт совпадает с поштучным, а градус меридиана равен pi / 180 радиуса Земли
+inline void TestComputeDistances(){
+    const geo::Coordinates from{55.611087, 37.20829};
+    const std::vector<geo::Coordinates> to{{55.611087, 37.20829}, {55.595884, 37.209755},
+                                          {56.611087, 37.20829}, {-33.86, 151.21}};
+    const std::vector<double> distances = geo::ComputeDistances(from, to);
+    assert(distances.size() == to.size());
+    for (size_t index = 0; index < to.size(); ++index){
+        assert(std::abs(distances[index] - geo::ComputeDistance(from, to[index])) < 1e-6);
+    }
+    assert(distances[0] == 0);
+    assert(std::abs(distances[2] - geo::radius_of_the_earth * std::acos(-1.0) / 180.0) < 1e-3);
+    assert(geo::ComputeDistances(from, {}).empty());
+}
+
+// Остановки S1 и S2 в 320 м друг от друга, T в 11 км к северу.
+// От S2 до T идёт быстрый автобус, от S1 до T — медленный кружной.
+inline std::shared_ptr<const FrozenCatalogue> MakeJourneyCatalogue(){
+    TransportCatalogue db;
+    StopPtr s1 = db.AddStop(std::string_view("S1"), {55.0, 37.0});
+    StopPtr s2 = db.AddStop(std::string_view("S2"), {55.0, 37.005});
+    StopPtr t = db.AddStop(std::string_view("T"), {55.1, 37.0});
+    db.AddDistance(s1, t, 50000);
+    db.AddDistance(s2, t, 11000);
+    db.AddBus("fast", {s2, t}, false);
+    db.AddBus("slow", {s1, t}, false);
+    db.SetRouteSettings({/* wait_time */ 6, /* velocity */ 40, /* pedestrian_velocity */ 5, /* walk_radius */ 1000});
+    db.Finalize();
+    return db.Freeze();
+}
+
+// Минуты пешком при 5 км/ч
+inline double WalkMinutes(geo::Coordinates from, geo::Coordinates to){
+    return geo::ComputeDistance(from, to) / 1000.0 / 5.0 * 60.0;
+}
+
+// Рядом с точками нет остановок: возможен только путь пешком, если точки достаточно близко
+inline void TestJourneyWithoutStops(){
+    auto db = MakeJourneyCatalogue();
+    router::RouteBuilder router(*db);
+    const geo::Coordinates from{54.9, 37.0};
+    const geo::Coordinates near{54.905, 37.0};
+    auto way = router.GetBestJourney(from, near);
+    assert(way && way->way.size() == 1);
+    assert(way->way.front().type == "Walk" && way->way.front().name.empty());
+    assert(std::abs(way->total_time - WalkMinutes(from, near)) < 1e-9);
+
+    assert(!router.GetBestJourney(from, {54.8, 37.0}));
+}
+
+// Пешком напрямую быстрее, чем ждать автобус
+inline void TestJourneyDirectWalk(){
+    auto db = MakeJourneyCatalogue();
+    router::RouteBuilder router(*db);
+    const geo::Coordinates from{55.0, 36.9999};
+    const geo::Coordinates to{55.0, 37.0051};
+    auto way = router.GetBestJourney(from, to);
+    assert(way && way->way.size() == 1 && way->way.front().type == "Walk");
+    assert(std::abs(way->total_time - WalkMinutes(from, to)) < 1e-9);
+}
+
+// Из нескольких начальных остановок выбирается не ближайшая, а дающая лучший маршрут
+inline void TestJourneyManySources(){
+    auto db = MakeJourneyCatalogue();
+    router::RouteBuilder router(*db);
+    const geo::Coordinates from{55.0, 37.0001};
+    const geo::Coordinates to{55.1, 37.0};
+    auto way = router.GetBestJourney(from, to);
+    assert(way && way->way.size() == 4);
+    assert(way->way[0].type == "Walk" && way->way[0].name == "S2");
+    assert(way->way[1].type == "Wait" && way->way[1].name == "S2");
+    assert(way->way[2].type == "Bus" && way->way[2].name == "fast");
+    assert(way->way[3].type == "Walk" && way->way[3].name.empty());
+    assert(std::abs(way->total_time - (WalkMinutes(from, {55.0, 37.005}) + 6 + 11.0 / 40.0 * 60.0)) < 1e-9);
+}
+
+// Нулевая скорость пешехода и отрицательный радиус отвергаются при разборе
+inline void TestRoutingSettingsValidation(){
+    auto load = [](const std::string& routing_settings){
+        TransportCatalogue db;
+        try {
+            reader::JsonReader reader(db, json::Load(std::string_view(
+                    R"({"base_requests": [], "routing_settings": )" + routing_settings + "}")));
+        } catch (const json::schema::SchemaError& error){
+            return std::string(error.what());
+        }
+        return std::string();
+    };
+    assert(load(R"({"bus_wait_time": 2, "bus_velocity": 30})").empty());
+    assert(load(R"({"bus_wait_time": 2, "bus_velocity": 30, "pedestrian_velocity": 0})")
+           == "routing_settings.pedestrian_velocity: expected a positive number");
+    assert(load(R"({"bus_wait_time": 2, "bus_velocity": 30, "walk_radius": -1})")
+           == "routing_settings.walk_radius: expected a non-negative number");
+    assert(load(R"({"bus_wait_time": 2, "bus_velocity": 0})")
+           == "routing_settings.bus_velocity: expected a positive number");
+}
+
+// Списки автобусов остановок сортируются в Finalize(), после неё автобусы вставляются по порядку
+inline void TestThroughBusesOrder(){
+    TransportCatalogue db;
+    StopPtr a = db.AddStop(std::string_view("A"), {55.6, 37.6});
+    StopPtr b = db.AddStop(std::string_view("B"), {55.61, 37.61});
+    db.AddDistance(a, b, 1000);
+    db.AddBus("3", {a, b, a}, true);
+    db.AddBus("1", {a, b}, false);
+    auto names = [&db](std::string_view stop){
+        std::vector<std::string_view> result;
+        for (BusPtr bus : db.GetStopInfo(stop)->through_buses){
+            result.push_back(bus->name);
+        }
+        return result;
+    };
+    assert((names("A") == std::vector<std::string_view>{"3", "1"}));
+
+    db.Finalize();
+    assert((names("A") == std::vector<std::string_view>{"1", "3"}));
+    db.UpsertBus("2", {b, a}, false);
+    assert((names("A") == std::vector<std::string_view>{"1", "2", "3"}));
+    db.RemoveBus("1");
+    assert((names("B") == std::vector<std::string_view>{"2", "3"}));
+
+    // После Finalize() расстояния пересчитывают длины маршрутов
+    db.AddDistance(a, b, 2000);
+    assert(db.GetBusInfo("2")->route_length == 3000);
+}
+
+// Справочник из двух остановок и автобуса 1 между ними
+inline void FillDeltaCatalogue(TransportCatalogue& db){
+    StopPtr a = db.AddStop(std::string_view("A"), {55.6, 37.6});
+    StopPtr b = db.AddStop(std::string_view("B"), {55.61, 37.61});
+    db.AddDistance(a, b, 1000);
+    db.AddBus("1", {a, b}, false);
+    db.Finalize();
+}
+
+// Сообщение об ошибке пачки изменений или пустая строка, если пачка применилась
+inline std::string ApplyDeltaText(TransportCatalogue& db, std::string_view delta){
+    try {
+        reader::ApplyDelta(db, json::Load(delta).GetRoot());
+    } catch (const json::schema::SchemaError& error){
+        return error.what();
+    }
+    return {};
+}
+
+inline void TestDeltaRejection(){
+    TransportCatalogue db;
+    FillDeltaCatalogue(db);
+    assert(ApplyDeltaText(db, R"([{"type": "Train", "name": "T"}])")
+           == "delta_requests[0].type: unknown delta type Train");
+    assert(ApplyDeltaText(db, R"([{"type": "Distance", "from": "A", "to": "Nowhere", "distance": 5}])")
+           == "delta_requests[0].to: unknown stop Nowhere");
+    assert(ApplyDeltaText(db, R"([{"type": "Bus", "name": "2", "stops": ["A", "Ghost"], "is_roundtrip": true}])")
+           == "delta_requests[0].stops[1]: unknown stop Ghost");
+    assert(ApplyDeltaText(db, R"([{"type": "Stop", "name": "C", "latitude": 55.6, "longitude": 37.6},
+                                  {"type": "Bus", "name": "2", "stops": ["A", "C"], "is_roundtrip": false}])")
+           == "delta_requests[1].stops: no road distance from A to C");
+    assert(ApplyDeltaText(db, R"([{"type": "Stop", "name": "A", "delete": true}])")
+           == "delta_requests[0]: stop is used by bus 1");
+    assert(ApplyDeltaText(db, R"([{"type": "Distance", "from": "B", "to": "A", "delete": true}])")
+           == "delta_requests[0]: distance is used by bus 1");
+    assert(ApplyDeltaText(db, R"({"type": "Stop"})") == "delta_requests: expected an array");
+}
+
+// Ошибка в последнем запросе пачки не оставляет изменений от предыдущих
+inline void TestDeltaRollback(){
+    TransportCatalogue db;
+    FillDeltaCatalogue(db);
+    const std::string error = ApplyDeltaText(db, R"([
+        {"type": "Stop", "name": "C", "latitude": 55.62, "longitude": 37.62, "road_distances": {"B": 700}},
+        {"type": "Bus", "name": "1", "delete": true},
+        {"type": "Bus", "name": "2", "stops": ["B", "C"], "is_roundtrip": false},
+        {"type": "Stop", "name": "B", "delete": true}])");
+    assert(error == "delta_requests[3]: stop is used by bus 2");
+    assert(db.GetStopCount() == 2 && db.GetStop("C") == nullptr);
+    assert(db.GetBusCount() == 1 && db.GetBus("1") != nullptr && db.GetBus("2") == nullptr);
+
+    VersionedCatalogue catalogue(/* warm_up_router */ false);
+    catalogue.Update([](TransportCatalogue& db, renderer::Settings&){
+        FillDeltaCatalogue(db);
+    });
+    const uint64_t number = catalogue.Pin()->number;
+    bool thrown = false;
+    try {
+        catalogue.Update([](TransportCatalogue& db, renderer::Settings&){
+            reader::ApplyDelta(db, json::Load(std::string_view(R"([{"type": "Bus", "name": "1", "delete": true},
+                                                                    {"type": "Train"}])")).GetRoot());
+        });
+    } catch (const json::schema::SchemaError&){
+        thrown = true;
+    }
+    assert(thrown && catalogue.Pin()->number == number);
+    assert(catalogue.Pin()->catalogue->FindBus("1"));
+
+    // Ссылки внутри одной пачки не зависят от порядка запросов
+    catalogue.Update([](TransportCatalogue& db, renderer::Settings&){
+        reader::ApplyDelta(db, json::Load(std::string_view(R"([
+            {"type": "Bus", "name": "2", "stops": ["B", "C"], "is_roundtrip": false},
+            {"type": "Bus", "name": "1", "delete": true},
+            {"type": "Stop", "name": "A", "delete": true},
+            {"type": "Stop", "name": "C", "latitude": 55.62, "longitude": 37.62, "road_distances": {"B": 700}}])")).GetRoot());
+    });
+    auto version = catalogue.Pin();
+    assert(version->number == number + 1);
+    assert(version->catalogue->GetStopCount() == 2 && !version->catalogue->FindStop("A"));
+    assert(version->catalogue->GetBusCount() == 1 && version->catalogue->FindBus("2"));
+}
+
+// Writer пишет то же, что json::Print для того же документа, в обоих режимах
+inline void TestWriterMatchesPrint(){
+    using namespace std::literals;
+    const json::Document document(json::Dict{
+        {"array"s, json::Array{1, 2.5, "a\"b\\c\n\t\r"s, true, json::Array{}, json::Dict{}}},
+        {"flag"s, false},
+        {"id"s, -7},
+        {"nested"s, json::Dict{{"x"s, 0.1}, {"y"s, json::Array{json::Dict{{"z"s, nullptr}}}}}},
+        {"text"s, ""s}});
+    for (json::PrintMode mode : {json::PrintMode::PRETTY, json::PrintMode::COMPACT}){
+        std::ostringstream expected;
+        json::Print(document, expected, mode);
+
+        std::ostringstream out;
+        json::Writer writer(out, mode);
+        writer.StartDict()
+            .Key("array"sv).StartArray()
+                .Value(1).Value(2.5).Value("a\"b\\c\n\t\r"sv).Value(true)
+                .StartArray().EndArray()
+                .StartDict().EndDict()
+            .EndArray()
+            .Key("flag"sv).Value(false)
+            .Key("id"sv).Value(-7)
+            .Key("nested"sv).StartDict()
+                .Key("x"sv).Value(0.1)
+                .Key("y"sv).StartArray().StartDict().Key("z"sv).Value(json::Node(nullptr)).EndDict().EndArray()
+            .EndDict()
+            .Key("text"sv).Value(""s)
+        .EndDict();
+        assert(out.str() == expected.str());
+    }
+
+    std::ostringstream compact;
+    json::Writer writer(compact, json::PrintMode::COMPACT);
+    writer.StartArray().Value("x").Value(json::Node(json::Array{1, 2})).EndArray();
+    assert(compact.str() == R"(["x",[1,2]])");
+}
+
+// Скобки и кавычки внутри строк не сбивают деление на части
+inline void TestSplit(){
+    using namespace std::literals;
+    const std::string_view input = R"( {"a\"]}": [1, {"x": "]}", "y": [[], {}]}, "q\"\\", -2.5e3 ],
+        "b" : {"c": [ "[" ]}, "d": null } )"sv;
+    const json::RootSections sections = json::SplitRoot(input);
+    assert(sections.size() == 3);
+    assert(sections[0].first == "a\"]}"s);
+    assert(sections[0].second == R"([1, {"x": "]}", "y": [[], {}]}, "q\"\\", -2.5e3 ])"sv);
+    assert(sections[1].first == "b"s && sections[1].second == R"({"c": [ "[" ]})"sv);
+    assert(sections[2].first == "d"s && sections[2].second == "null"sv);
+
+    const std::vector<std::string_view> items = json::SplitArray(sections[0].second);
+    assert((items == std::vector<std::string_view>{"1"sv, R"({"x": "]}", "y": [[], {}]})"sv,
+                                                   R"("q\"\\")"sv, "-2.5e3"sv}));
+    assert(json::SplitArray(" [ ] "sv).empty());
+    for (std::string_view item : items){
+        json::Load(item);
+    }
+
+    for (std::string_view broken : {"[1, 2"sv, "[1 2]"sv, R"(["]])"sv}){
+        bool thrown = false;
+        try {
+            json::SplitArray(broken);
+        } catch (const json::ParsingError&){
+            thrown = true;
+        }
+        assert(thrown);
+    }
+    bool thrown = false;
+    try {
+        json::SplitRoot("[]"sv);
+    } catch (const json::ParsingError&){
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+// Вход из 1200 остановок с цепочкой расстояний и 599 автобусов по три остановки.
+// Имя каждой седьмой остановки содержит экранированную кавычку.
+inline std::string MakeChunkedInput(){
+    const int stop_count = 1200;
+    const int bus_count = 599;
+    auto name = [](int index){
+        return "S" + std::to_string(index) + (index % 7 == 0 ? "\\\"q" : "");
+    };
+    std::ostringstream out;
+    out << R"({"base_requests": [)";
+    for (int index = 0; index < stop_count; ++index){
+        out << (index ? ", " : "") << R"({"type": "Stop", "name": ")" << name(index)
+            << R"(", "latitude": )" << 55.5 + index * 1e-4 << R"(, "longitude": 37.5, "road_distances": {)";
+        if (index + 1 < stop_count){
+            out << '"' << name(index + 1) << R"(": )" << 100 + index % 50;
+        }
+        out << "}}";
+    }
+    for (int bus = 0; bus < bus_count; ++bus){
+        out << R"(, {"type": "Bus", "name": "B)" << bus << R"(", "stops": [")" << name(2 * bus) << R"(", ")"
+            << name(2 * bus + 1) << R"(", ")" << name(2 * bus + 2) << R"("], "is_roundtrip": false})";
+    }
+    out << R"(], "routing_settings": {"bus_wait_time": 2, "bus_velocity": 30}, "stat_requests": [)";
+    for (int index = 0; index < 900; ++index){
+        out << (index ? ", " : "") << R"({"id": )" << 2 * index << R"(, "type": "Bus", "name": "B)" << index % bus_count
+            << R"("}, {"id": )" << 2 * index + 1 << R"(, "type": "Stop", "name": ")" << name(index) << R"("})";
+    }
+    out << "]}";
+    return out.str();
+}
+
+// Параллельный разбор по частям даёт те же ответы, что и потоковый
+inline void TestParallelLoad(){
+    const std::string input = MakeChunkedInput();
+    auto run = [&input](size_t threads, size_t parallel_input_size){
+        VersionedCatalogue catalogue(/* warm_up_router */ false);
+        std::unique_ptr<reader::JsonReader> json_reader;
+        catalogue.Update([&](TransportCatalogue& db, renderer::Settings&){
+            json_reader = std::make_unique<reader::JsonReader>(db, input, threads, parallel_input_size);
+        });
+        std::ostringstream out;
+        json_reader->PrintStat(catalogue.Pin()->handler, out);
+        return out.str();
+    };
+    const std::string sequential = run(1, reader::JsonReader::PARALLEL_INPUT_SIZE);
+    assert(sequential.find("not found") == std::string::npos);
+    assert(sequential == run(2, 0));
+    assert(sequential == run(4, 0));
+}
+
+// Каждый ключ находит своё первое вхождение, чужая строка — номер другого ключа
+inline void TestPerfectHash(){
+    using namespace std::literals;
+    assert(PerfectHash().Empty());
+    for (size_t size : {1, 2, 3, 5, 17, 1000, 5000}){
+        std::vector<std::string> names;
+        for (size_t i = 0; i < size; ++i){
+            names.push_back("key "s + std::to_string(i));
+        }
+        // Повторы ссылаются на ключи, уже встреченные выше
+        for (size_t i = 0; i < size; i += 3){
+            names.push_back(names[i]);
+        }
+        const std::vector<std::string_view> keys(names.begin(), names.end());
+        const PerfectHash hash(keys);
+        assert(!hash.Empty());
+        for (size_t i = 0; i < keys.size(); ++i){
+            assert(hash(keys[i]) == (i < size ? i : (i - size) * 3));
+        }
+        for (std::string_view missing : {""sv, "key"sv, "key -1"sv, "yek 0"sv, "key 5000"sv}){
+            const uint32_t index = hash(missing);
+            assert(index < size && keys[index] != missing);
+        }
+    }
+}
+
+// Поиск по сетке сверяется с перебором всех точек. Точки стоят в узлах решётки,
+// то есть на границах ячеек, а между двумя скоплениями остаются пустые ячейки.
+inline void CheckGridIndex(const std::vector<geo::Coordinates>& points, const std::vector<geo::Coordinates>& queries){
+    const double eps = 1e-3;
+    const geo::GridIndex index(points);
+    for (geo::Coordinates query : queries){
+        const std::vector<double> distances = geo::ComputeDistances(query, points);
+        std::vector<double> sorted = distances;
+        std::sort(sorted.begin(), sorted.end());
+
+        for (size_t count : {0, 1, 5, 150, 1000}){
+            const auto nearest = index.FindNearest(query, count);
+            assert(nearest.size() == std::min(count, points.size()));
+            for (size_t i = 0; i < nearest.size(); ++i){
+                assert(std::abs(nearest[i].distance - distances[nearest[i].index]) < eps);
+                assert(std::abs(nearest[i].distance - sorted[i]) < eps);
+                assert(i == 0 || nearest[i - 1].distance <= nearest[i].distance);
+            }
+        }
+
+        for (double radius : {0.0, 500.0, 1113.2, 50000.0}){
+            const auto found = index.FindInRadius(query, radius);
+            std::vector<bool> is_found(points.size());
+            for (size_t i = 0; i < found.size(); ++i){
+                assert(found[i].distance <= radius + eps);
+                assert(std::abs(found[i].distance - distances[found[i].index]) < eps);
+                assert(i == 0 || found[i - 1].distance <= found[i].distance);
+                is_found[found[i].index] = true;
+            }
+            for (size_t i = 0; i < points.size(); ++i){
+                assert(is_found[i] || distances[i] > radius - eps);
+            }
+        }
+    }
+
+    // Границы прямоугольников совпадают с координатами точек и включаются в него
+    for (geo::Coordinates min : queries){
+        for (geo::Coordinates max : queries){
+            std::vector<uint32_t> expected;
+            for (uint32_t i = 0; i < points.size(); ++i){
+                if (points[i].lat >= min.lat && points[i].lat <= max.lat
+                    && points[i].lng >= min.lng && points[i].lng <= max.lng){
+                    expected.push_back(i);
+                }
+            }
+            assert(index.FindInBox(min, max) == expected);
+        }
+    }
+}
+
+inline void TestGridIndex(){
+    auto lattice = [](double lat, double lng, int i, int j){
+        return geo::Coordinates{lat + i * 0.01, lng + j * 0.01};
+    };
+    std::vector<geo::Coordinates> points;
+    std::vector<geo::Coordinates> queries;
+    for (int i = 0; i < 10; ++i){
+        for (int j = 0; j < 10; ++j){
+            points.push_back(lattice(55.0, 37.0, i, j));
+            points.push_back(lattice(55.5, 37.6, i, j));
+        }
+    }
+    points.push_back(points[7]);
+    for (int i = 0; i < 10; i += 3){
+        for (int j = 0; j < 10; j += 4){
+            queries.push_back(lattice(55.0, 37.0, i, j));
+            queries.push_back(lattice(55.5, 37.6, i, j));
+        }
+    }
+    queries.push_back({55.3, 37.3});
+    queries.push_back({55.005, 37.005});
+    queries.push_back({56.0, 36.0});
+    queries.push_back({54.0, 38.5});
+    CheckGridIndex(points, queries);
+
+    CheckGridIndex({{55.1, 37.1}}, {{55.1, 37.1}, {55.0, 37.2}});
+    CheckGridIndex({{55.1, 37.1}, {55.1, 37.1}, {55.1, 37.1}}, {{55.1, 37.1}, {55.0, 37.2}});
+    CheckGridIndex({{55.1, 37.1}, {55.1, 37.2}, {55.1, 37.3}}, {{55.1, 37.2}, {55.0, 37.25}});
+
+    const geo::GridIndex empty;
+    assert(empty.FindNearest({55.0, 37.0}, 3).empty());
+    assert(empty.FindInRadius({55.0, 37.0}, 1000).empty());
+    assert(empty.FindInBox({54.0, 36.0}, {56.0, 38.0}).empty());
+}
+
+// Пересечение автобусов сверяется с перебором как для остановок со строками битов,
+// так и для остановок, у которых есть только отсортированный список автобусов
+inline void TestCommonBuses(){
+    const int stop_count = 30;
+    const int bus_count = 200;
+    TransportCatalogue db;
+    std::vector<StopPtr> stops;
+    for (int stop = 0; stop < stop_count; ++stop){
+        stops.push_back(db.AddStop("S" + std::to_string(stop), {55.6 + stop * 0.001, 37.6}));
+        for (int other = 0; other < stop; ++other){
+            db.AddDistance(stops[other], stops[stop], 100 * (stop - other));
+        }
+    }
+    for (int bus = 0; bus < bus_count; ++bus){
+        std::vector<StopPtr> route;
+        for (int stop = 0; stop + 1 < stop_count; ++stop){
+            // Первые шесть остановок общие для многих автобусов, остальные — для единиц
+            const bool is_on_route = stop < 6 ? (bus + stop) % 3 != 0
+                                              : (bus * 7 + stop * 13) % (stop < 18 ? 23 : 67) == 0;
+            if (is_on_route){
+                route.push_back(stops[stop]);
+            }
+        }
+        db.AddBus("B" + std::to_string(bus), std::move(route), false);
+    }
+    db.Finalize();
+    const FrozenCatalogue frozen(db);
+
+    std::vector<std::vector<BusId>> buses_by_stop;
+    size_t row_count = 0;
+    for (StopId stop = 0; stop < stop_count; ++stop){
+        const auto buses = frozen.GetBusesByStop(stop);
+        buses_by_stop.emplace_back(buses.begin(), buses.end());
+        // Строка битов заводится, когда она не больше списка из 32-битных номеров
+        row_count += buses_by_stop.back().size() * 32 >= bus_count;
+    }
+    assert(row_count > 6 && row_count < stop_count - 1);
+
+    auto check = [&](const std::vector<StopId>& query){
+        std::vector<BusId> expected = buses_by_stop[query.front()];
+        for (StopId stop : query){
+            std::vector<BusId> common;
+            std::set_intersection(expected.begin(), expected.end(),
+                                  buses_by_stop[stop].begin(), buses_by_stop[stop].end(), std::back_inserter(common));
+            expected = std::move(common);
+        }
+        assert(frozen.FindCommonBuses(query) == expected);
+    };
+    assert(frozen.FindCommonBuses({}).empty());
+    for (StopId first = 0; first < stop_count; ++first){
+        check({first});
+        for (StopId second = 0; second < stop_count; ++second){
+            check({first, second});
+            for (StopId third = 0; third < 8; ++third){
+                check({first, second, third});
+            }
+        }
+    }
+}
+
+// Числа на границе быстрого пути разбора совпадают с strtod до бита
+inline void TestNumbers(){
+    const std::vector<std::string> numbers = {
+        "0", "-0", "1", "-1", "2147483647", "-2147483648", "2147483648", "-2147483649",
+        "-0.0", "0.0", "0.1", "0.3", "-1.5E+22", "3.141592653589793",
+        // 15 цифр ещё считаются точно, 16 и более — уже нет
+        "123456789012345", "1234567890123456", "12345678901234567", "9007199254740993",
+        "0.123456789012345", "0.1234567890123456", "1.2345678901234567e5",
+        // Мантисса больше 2^53: округление при делении было бы вторым
+        "90071992547409.93", "900719925474099.7",
+        // Степень 10 до 22 представима точно, 23 — уже нет
+        "1e22", "1e23", "1e-22", "1e-23", "0.1e23", "10e22", "123456789012345e22", "123456789012345e23",
+        "100000000000000000000000e-23", "0.000000000000000000000000000001",
+        // Денормализованные и граничные значения
+        "4.9e-324", "2.4703282292062328e-324", "1e-320", "2.2250738585072011e-308", "2.2250738585072014e-308",
+        "1.7976931348623157e308",
+    };
+    for (const std::string& number : numbers){
+        const json::Node node = json::Load(std::string_view(number)).GetRoot();
+        char* end = nullptr;
+        if (node.IsInt()){
+            assert(node.AsInt() == std::strtol(number.c_str(), &end, 10));
+        } else {
+            const double expected = std::strtod(number.c_str(), &end);
+            const double value = node.AsDouble();
+            assert(std::memcmp(&value, &expected, sizeof(double)) == 0);
+        }
+        assert(end == number.c_str() + number.size());
+    }
+    assert(json::Load(std::string_view("-0")).GetRoot().IsInt());
+    assert(std::signbit(json::Load(std::string_view("-0.0")).GetRoot().AsDouble()));
+
+    for (const char* broken : {"-", "1.", ".5", "1e", "1e+", "1e400"}){
+        bool thrown = false;
+        try {
+            json::Load(std::string_view(broken));
+        } catch (const json::ParsingError&){
+            thrown = true;
+        }
+        assert(thrown);
+    }
+}
+
+// Повторный ключ в любом словаре документа отвергается, как и в json::Load
+inline void TestArenaDuplicateKeys(){
+    using namespace std::literals;
+    const json::arena::Document document = json::arena::Load(
+        R"({"b": {"a": 1, "b": [{"a": 2}, {"a": 3}]}, "a": "x", "c": null})"sv);
+    const json::arena::Dict root = document.GetRoot().AsDict();
+    assert(root.size() == 3);
+    assert(root[0].key == "a"sv && root[1].key == "b"sv && root[2].key == "c"sv);
+    assert(root.at("a"sv).AsString() == "x"sv && root.count("d"sv) == 0 && root.find("d"sv) == root.end());
+    assert(root.at("b"sv).AsDict().at("b"sv).AsArray()[1].AsDict().at("a"sv).AsInt() == 3);
+
+    for (std::string_view input : {R"({"a": 1, "a": 2})"sv, R"({"a": 1, "b": 2, "a": 1})"sv,
+                                   R"([{"a": {"x": 1, "y": 2, "x": 3}}])"sv, R"({"a\"": 1, "a"": 2})"sv}){
+        bool thrown = false;
+        try {
+            json::arena::Load(input);
+        } catch (const json::ParsingError&){
+            thrown = true;
+        }
+        assert(thrown);
+        thrown = false;
+        try {
+            json::Load(input);
+        } catch (const json::ParsingError&){
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    // После Clear память первого блока используется снова, выравнивание сохраняется
+    json::arena::Arena arena;
+    const std::string_view copy = arena.CopyString("abc"sv);
+    assert(copy == "abc"sv);
+    double* numbers = arena.Allocate<double>(3);
+    assert(reinterpret_cast<uintptr_t>(numbers) % alignof(double) == 0);
+    const std::string big(100 * 1024, 'z');
+    assert(arena.CopyString(big) == big);
+    assert(arena.GetMemoryUsage().count == 2);
+    arena.Clear();
+    assert(arena.GetMemoryUsage().count == 1);
+    assert(arena.CopyString("abc"sv).data() == copy.data());
+}
+
+// Строки без экранирования ссылаются на вход, экранированные и все строки json::arena::Load —
+// на память документа. Справочник не хранит ссылок на вход после загрузки.
+inline void TestBorrowedStrings(){
+    using namespace std::literals;
+    const std::string input = R"({"plain": "value", "esc\"key": "a\nb", "list": ["x", "y\tA", ""]})";
+    const json::arena::Document borrowed = json::arena::LoadBorrowed(input);
+    const json::arena::Document copied = json::arena::Load(input);
+    for (const json::arena::Document* document : {&borrowed, &copied}){
+        const bool is_borrowed = document == &borrowed;
+        const json::arena::Dict root = document->GetRoot().AsDict();
+        assert(root[0].key == "esc\"key"sv && !json::arena::IsWithin(root[0].key, input));
+        assert(root[0].value.AsString() == "a\nb"sv && !json::arena::IsWithin(root[0].value.AsString(), input));
+        const json::arena::Array list = root.at("list"sv).AsArray();
+        assert(list[0].AsString() == "x"sv && json::arena::IsWithin(list[0].AsString(), input) == is_borrowed);
+        assert(list[1].AsString() == "y\tA"sv && !json::arena::IsWithin(list[1].AsString(), input));
+        assert(list[2].AsString().empty());
+        assert(root[2].key == "plain"sv && json::arena::IsWithin(root[2].key, input) == is_borrowed);
+        assert(root[2].value.AsString() == "value"sv && json::arena::IsWithin(root[2].value.AsString(), input) == is_borrowed);
+    }
+
+    const std::string_view text = "abcdef"sv;
+    assert(json::arena::IsWithin(text, text) && json::arena::IsWithin(text.substr(6), text));
+    assert(json::arena::IsWithin(text.substr(2, 3), text));
+    assert(!json::arena::IsWithin(std::string_view(text.data() + 4, 3), text));
+    assert(!json::arena::IsWithin(text, text.substr(1)) && !json::arena::IsWithin(text.substr(0, 0), {}));
+
+    // Вход затирается сразу после загрузки, и ответы и следующая версия от этого не меняются
+    const std::string original = MakeChunkedInput();
+    for (size_t threads : {1, 4}){
+        auto run = [&original, threads](bool is_clobbered){
+            std::string chunked_input = original;
+            VersionedCatalogue catalogue(/* warm_up_router */ false);
+            std::unique_ptr<reader::JsonReader> json_reader;
+            catalogue.Update([&](TransportCatalogue& db, renderer::Settings&){
+                json_reader = std::make_unique<reader::JsonReader>(db, chunked_input, threads, 0);
+            });
+            if (is_clobbered){
+                std::fill(chunked_input.begin(), chunked_input.end(), '?');
+            }
+            catalogue.Update([](TransportCatalogue&, renderer::Settings&){});
+            const auto version = catalogue.Pin();
+            const auto stop = version->catalogue->FindStop("S7\"q"sv);
+            assert(stop && version->catalogue->GetStopName(*stop) == "S7\"q"sv);
+            std::ostringstream out;
+            json_reader->PrintStat(version->handler, out);
+            return out.str();
+        };
+        assert(run(false) == run(true));
+    }
+}
+
+// Текст ошибки разбора input по схеме T. Узлы json::Node и json::arena::Node дают одинаковые ошибки.
+template <typename T>
+std::string GetSchemaError(std::string_view input){
+    std::string errors[2];
+    try {
+        json::schema::Decode<T>(json::Load(input).GetRoot());
+    } catch (const json::schema::SchemaError& error){
+        errors[0] = error.what();
+    }
+    try {
+        json::schema::Decode<T>(json::arena::Load(input).GetRoot());
+    } catch (const json::schema::SchemaError& error){
+        errors[1] = error.what();
+    }
+    assert(errors[0] == errors[1]);
+    return errors[0];
+}
+
+// В сообщении об ошибке указан путь до значения, не подходящего под схему
+inline void TestSchemaErrors(){
+    using namespace reader::requests;
+    using namespace std::literals;
+    assert(GetSchemaError<StopRequest>(R"({"name": "A", "latitude": 1, "longitude": 2.5, "extra": [1]})").empty());
+    assert(GetSchemaError<StopRequest>("[]") == "expected a dict");
+    assert(GetSchemaError<StopRequest>(R"({"latitude": 1, "longitude": 2})") == "name: missing required key");
+    assert(GetSchemaError<StopRequest>(R"({"name": "A", "latitude": "1", "longitude": 2})")
+           == "latitude: expected a number");
+    assert(GetSchemaError<StopRequest>(R"({"name": "A", "latitude": 1, "longitude": 2, "road_distances": {"B": 1, "C": "far"}})")
+           == "road_distances.C: expected a number");
+    assert(GetSchemaError<StopRequest>(R"({"name": "A", "latitude": 1, "longitude": 2, "road_distances": []})")
+           == "road_distances: expected a dict");
+    assert(GetSchemaError<BusRequest>(R"({"name": "1", "stops": ["A", 5], "is_roundtrip": true})")
+           == "stops[1]: expected a string");
+    assert(GetSchemaError<BusRequest>(R"({"name": "1", "stops": "A", "is_roundtrip": true})")
+           == "stops: expected an array");
+    assert(GetSchemaError<BusRequest>(R"({"name": "1", "stops": [], "is_roundtrip": 1})")
+           == "is_roundtrip: expected a bool");
+    assert(GetSchemaError<NamedStatRequest>(R"({"id": 1.5, "name": "A"})") == "id: expected an int");
+    assert(GetSchemaError<RenderSettingsRequest>(R"({"color_palette": ["red", [1, 2]]})")
+           .rfind("color_palette[1]: ", 0) == 0);
+
+    auto get_tag_error = [](std::string_view input){
+        try {
+            json::schema::GetTag(json::arena::Load(input).GetRoot(), "type"sv);
+        } catch (const json::schema::SchemaError& error){
+            return std::string(error.what());
+        }
+        return std::string();
+    };
+    assert(get_tag_error(R"({"name": "A", "type": "Stop"})").empty());
+    assert(get_tag_error(R"({"name": "A"})") == "type: missing required key");
+    assert(get_tag_error(R"({"type": 1})") == "type: expected a string");
+    assert(get_tag_error(R"("Stop")") == "expected a dict");
+
+    // Все пути загрузки дают один и тот же путь до ошибки в base_requests
+    const std::string input = R"({"base_requests": [
+        {"type": "Stop", "name": "A", "latitude": 55.6, "longitude": 37.6},
+        {"type": "Bus", "name": "1", "stops": ["A", {}], "is_roundtrip": true}
+    ], "routing_settings": {"bus_wait_time": 2, "bus_velocity": 30}})";
+    auto load_error = [&input](auto load){
+        TransportCatalogue db;
+        try {
+            load(db);
+        } catch (const json::schema::SchemaError& error){
+            return std::string(error.what());
+        }
+        return std::string();
+    };
+    const std::string expected = "base_requests[1].stops[1]: expected a string";
+    assert(load_error([&input](TransportCatalogue& db){ reader::JsonReader(db, json::Load(std::string_view(input))); })
+           == expected);
+    assert(load_error([&input](TransportCatalogue& db){ reader::JsonReader(db, std::string_view(input), 1); })
+           == expected);
+    assert(load_error([&input](TransportCatalogue& db){ reader::JsonReader(db, std::string_view(input), 4, 0); })
+           == expected);
+
+    // Запросы stat_requests разбираются при ответе на них
+    VersionedCatalogue catalogue(/* warm_up_router */ false);
+    std::unique_ptr<reader::JsonReader> json_reader;
+    catalogue.Update([&json_reader](TransportCatalogue& db, renderer::Settings&){
+        json_reader = std::make_unique<reader::JsonReader>(db, std::string_view(R"({"base_requests": [],
+            "routing_settings": {"bus_wait_time": 2, "bus_velocity": 30},
+            "stat_requests": [{"id": 1, "type": "Bus", "name": "1"}, {"id": 2, "type": "Bus"}]})"));
+    });
+    std::string stat_error;
+    try {
+        std::ostringstream out;
+        json_reader->PrintStat(catalogue.Pin()->handler, out);
+    } catch (const json::schema::SchemaError& error){
+        stat_error = error.what();
+    }
+    assert(stat_error == "stat_requests[1].name: missing required key");
+}
+
+// Одинаковые имена разных городов хранятся в общем пуле один раз, а сами города независимы
+inline void TestMultiCityNames(){
+    using namespace std::literals;
+    StringPool pool;
+    const std::string_view first = pool.Intern("name"sv);
+    assert(pool.Intern(std::string("name")).data() == first.data());
+    assert(pool.Intern("other"sv) == "other"sv && pool.Size() == 2);
+
+    MultiCityCatalogue cities(/* warm_up_router */ false);
+    auto city = [](std::string_view only_stop){
+        return R"({"base_requests": [
+            {"type": "Stop", "name": "A", "latitude": 55.6, "longitude": 37.6, "road_distances": {"B": 1000}},
+            {"type": "Stop", "name": "B", "latitude": 55.61, "longitude": 37.61, "road_distances": {")"s
+            + std::string(only_stop) + R"(": 500}},
+            {"type": "Stop", "name": ")" + std::string(only_stop) + R"(", "latitude": 55.62, "longitude": 37.62},
+            {"type": "Bus", "name": "1", "stops": ["A", "B", ")" + std::string(only_stop) + R"("], "is_roundtrip": false}
+        ], "routing_settings": {"bus_wait_time": 2, "bus_velocity": 30}})";
+    };
+    const reader::MultiCityJsonReader json_reader(cities, json::Load(std::string_view(
+        R"({"cities": {"north": )" + city("X") + R"(, "south": )" + city("Y") + R"(}, "stat_requests": [
+            {"id": 1, "city": "north", "type": "Stop", "name": "X"},
+            {"id": 2, "city": "south", "type": "Stop", "name": "X"},
+            {"id": 3, "city": "east", "type": "Stop", "name": "A"}
+        ]})")));
+    assert(cities.GetCityCount() == 2 && cities.FindCity("east"sv) == nullptr);
+    assert(&cities.AddCity("north"sv) == cities.FindCity("north"sv));
+    // A, B, 1, X и Y
+    assert(cities.GetNames().Size() == 5);
+
+    std::ostringstream out;
+    json_reader.PrintStat(out);
+    const json::Array answers = json::Load(std::string_view(out.str())).GetRoot().AsArray();
+    assert(answers.size() == 3);
+    assert(answers[0].AsDict().count("buses"s) == 1);
+    assert(answers[1].AsDict().at("error_message"s).AsString() == "not found"s);
+    assert(answers[2].AsDict().at("error_message"s).AsString() == "not found"s);
+
+    const char* north_name = nullptr;
+    cities.FindCity("north"sv)->Update([&north_name](TransportCatalogue& db, renderer::Settings&){
+        north_name = db.GetStop("A")->name.data();
+        db.RemoveBus("1");
+    });
+    cities.FindCity("south"sv)->Update([north_name](TransportCatalogue& db, renderer::Settings&){
+        assert(db.GetStop("A")->name.data() == north_name);
+        assert(db.GetBus("1") != nullptr);
+    });
+    assert(!cities.FindCity("north"sv)->Pin()->catalogue->FindBus("1"sv));
+    assert(cities.FindCity("south"sv)->Pin()->catalogue->FindBus("1"sv));
+    assert(cities.GetNames().Size() == 5);
+}
+
+inline void RunAll(){
+    TestUpdateRollback();
+    TestPerfectHash();
+    TestGridIndex();
+    TestCommonBuses();
+    TestNumbers();
+    TestArenaDuplicateKeys();
+    TestSchemaErrors();
+    TestMultiCityNames();
+    TestCatalogueCopy();
+    TestComputeDistances();
+    TestThroughBusesOrder();
+    TestDeltaRejection();
+    TestDeltaRollback();
+    TestWriterMatchesPrint();
+    TestSplit();
+    TestParallelLoad();
+    TestBorrowedStrings();
+    TestJourneyWithoutStops();
+    TestJourneyDirectWalk();
+    TestJourneyManySources();
+    TestRoutingSettingsValidation();
+    std::cerr << "Tests passed\n";
+}
+
+}  // namespace tests
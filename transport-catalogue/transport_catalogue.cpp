@@ -1,26 +1,137 @@
 #include "transport_catalogue.h"
 
+#include <algorithm>
+#include <stdexcept>
 #include <unordered_set>
 
 using namespace std;
 
-void TransportCatalogue::AddBus(sv name, const vector<StopPtr>& route, const vector<StopPtr>& edge_stops){
+namespace {
+
+bool ByName(BusPtr lhs, BusPtr rhs){
+    return lhs->name < rhs->name;
+}
+
+// Удаляет элемент с сохранением порядка остальных
+template <typename T>
+void EraseItem(vector<T>& items, const T& item){
+    auto it = find(items.begin(), items.end(), item);
+    if (it != items.end()){
+        items.erase(it);
+    }
+}
+
+}  // namespace
+
+TransportCatalogue::TransportCatalogue()
+: names_(make_shared<StringPool>()){
+}
+
+TransportCatalogue::TransportCatalogue(shared_ptr<StringPool> names)
+: names_(std::move(names)){
+}
+
+// Ячейки удалённых объектов не копируются
+TransportCatalogue::TransportCatalogue(const TransportCatalogue& other)
+: route_settings_(other.route_settings_)
+, is_finalized_(other.is_finalized_)
+, names_(other.names_){
+    unordered_map<StopPtr, StopPtr> stops;
+    stops.reserve(other.stop_order_.size());
+    for (StopPtr stop : other.stop_order_){
+        stops.emplace(stop, PlaceStop(stop->name, stop->coordinates));
+    }
+
+    unordered_map<BusPtr, BusPtr> buses;
+    buses.reserve(other.bus_order_.size());
+    for (BusPtr bus : other.bus_order_){
+        Bus& copy = buses_data_.emplace_back(*bus);
+        for (StopPtr& stop : copy.stops){
+            stop = stops.at(stop);
+        }
+        buses_[copy.name] = &copy;
+        bus_order_.push_back(&copy);
+        bus_info_[&copy] = other.bus_info_.at(bus);
+        buses.emplace(bus, &copy);
+    }
+
+    for (const auto& [stop, stop_info] : other.stop_info_){
+        auto& through_buses = stop_info_.at(stops.at(stop)).through_buses;
+        through_buses.reserve(stop_info.through_buses.size());
+        for (BusPtr bus : stop_info.through_buses){
+            through_buses.push_back(buses.at(bus));
+        }
+    }
+
+    distances_.reserve(other.distances_.size());
+    for (const auto& [from_to, distance] : other.distances_){
+        distances_.emplace(make_pair(stops.at(from_to.first), stops.at(from_to.second)), distance);
+    }
+    for (const auto& [stop, linked] : other.linked_stops_){
+        auto& copy = linked_stops_[stops.at(stop)];
+        copy.reserve(linked.size());
+        for (StopPtr other_stop : linked){
+            copy.push_back(stops.at(other_stop));
+        }
+    }
+}
+
+void TransportCatalogue::AddBus(string name, vector<StopPtr> stops, bool is_roundtrip){
     Bus bus{};
     
-    bus.name = std::move(name);
-    bus.route = std::move(route);
-    bus.edge_stops = std::move(edge_stops);
-
-    Bus* bus_ptr = &buses_data_.emplace_back(std::move(bus));
+    bus.name = names_->Intern(std::move(name));
+    bus.stops = std::move(stops);
+    bus.is_roundtrip = is_roundtrip;
+
+    Bus* bus_ptr = nullptr;
+    if (free_buses_.empty()){
+        bus_ptr = &buses_data_.emplace_back(std::move(bus));
+    } else {
+        bus_ptr = free_buses_.back();
+        free_buses_.pop_back();
+        *bus_ptr = std::move(bus);
+    }
     buses_[bus_ptr -> name] = bus_ptr;
+    bus_order_.push_back(bus_ptr);
 
     AddBusInfo(bus_ptr);
     AddBusToThroughStops(bus_ptr);
 }
 
+void TransportCatalogue::UpsertBus(sv name, vector<StopPtr> stops, bool is_roundtrip){
+    auto it = buses_.find(name);
+    if (it == buses_.end()){
+        AddBus(string(name), std::move(stops), is_roundtrip);
+        return;
+    }
+    Bus* bus = it->second;
+    RemoveBusFromThroughStops(bus);
+    bus->stops = std::move(stops);
+    bus->is_roundtrip = is_roundtrip;
+
+    AddBusInfo(bus);
+    AddBusToThroughStops(bus);
+}
+
+void TransportCatalogue::RemoveBus(sv name){
+    auto it = buses_.find(name);
+    if (it == buses_.end()){
+        return;
+    }
+    Bus* bus = it->second;
+    RemoveBusFromThroughStops(bus);
+    bus_info_.erase(bus);
+    buses_.erase(it);
+    EraseItem(bus_order_, static_cast<BusPtr>(bus));
+
+    *bus = {};
+    free_buses_.push_back(bus);
+}
+
 const Bus* TransportCatalogue::GetBus(sv name) const {
-    if (buses_.count(name)){
-        return buses_.at(name);
+    auto it = buses_.find(name);
+    if (it != buses_.end()){
+        return it->second;
     }
     return nullptr;
 }
@@ -35,31 +146,111 @@ const BusInfo* TransportCatalogue::GetBusInfo(sv name) const {
     return &bus_info_.at(bus);
 }
 
-std::vector<BusPtr> TransportCatalogue::GetAllBuses() const {
-    std::vector<BusPtr> result;
-    for (auto [bus, x] : bus_info_){
-        result.push_back(bus);
-    }
-    return result;
+TransportCatalogue::BusRange TransportCatalogue::GetAllBuses() const {
+    return ranges::AsRange(bus_order_);
+}
+
+size_t TransportCatalogue::GetBusCount() const {
+    return bus_order_.size();
+}
+
+const Stop* TransportCatalogue::AddStop(string name, geo::Coordinates coordinates){
+    return PlaceStop(names_->Intern(std::move(name)), coordinates);
 }
 
 const Stop* TransportCatalogue::AddStop(sv name, geo::Coordinates coordinates){
+    return PlaceStop(names_->Intern(name), coordinates);
+}
+
+const Stop* TransportCatalogue::PlaceStop(sv name, geo::Coordinates coordinates){
 
         Stop stop;
 
-        stop.name = std::move(name);
+        stop.name = name;
         stop.coordinates = std::move(coordinates);
 
-        Stop* stop_ptr = &stops_data_.emplace_back(std::move(stop));
+        Stop* stop_ptr = nullptr;
+        if (free_stops_.empty()){
+            stop_ptr = &stops_data_.emplace_back(std::move(stop));
+        } else {
+            stop_ptr = free_stops_.back();
+            free_stops_.pop_back();
+            *stop_ptr = std::move(stop);
+        }
         stops_[stop_ptr->name] = stop_ptr;
         stop_info_[stop_ptr] = {};
+        stop_order_.push_back(stop_ptr);
 
         return stop_ptr;
 }
 
+const Stop* TransportCatalogue::UpsertStop(sv name, geo::Coordinates coordinates){
+    auto it = stops_.find(name);
+    if (it == stops_.end()){
+        return AddStop(string(name), coordinates);
+    }
+    Stop* stop = it->second;
+    if (stop->coordinates == coordinates){
+        return stop;
+    }
+    stop->coordinates = coordinates;
+
+    // Географические расстояния хранятся вместе с дорожными и пересчитываются здесь
+    auto links = linked_stops_.find(stop);
+    if (links != linked_stops_.end()){
+        vector<geo::Coordinates> others;
+        others.reserve(links->second.size());
+        for (StopPtr other : links->second){
+            others.push_back(other->coordinates);
+        }
+        const vector<double> geo_distances = geo::ComputeDistances(stop->coordinates, others);
+        for (size_t index = 0; index < others.size(); ++index){
+            StopPtr other = links->second[index];
+            if (auto distance = distances_.find({stop, other}); distance != distances_.end()){
+                distance->second.geo = geo_distances[index];
+            }
+            if (auto distance = distances_.find({other, stop}); distance != distances_.end()){
+                distance->second.geo = geo_distances[index];
+            }
+        }
+    }
+    UpdateBusInfo(stop);
+    return stop;
+}
+
+void TransportCatalogue::RemoveStop(sv name){
+    auto it = stops_.find(name);
+    if (it == stops_.end()){
+        return;
+    }
+    Stop* stop = it->second;
+    if (!stop_info_.at(stop).through_buses.empty()){
+        throw logic_error("Stop "s + string(stop->name) + " is used by buses"s);
+    }
+
+    auto links = linked_stops_.find(stop);
+    if (links != linked_stops_.end()){
+        for (StopPtr other : links->second){
+            distances_.erase({stop, other});
+            distances_.erase({other, stop});
+            if (other != stop){
+                EraseItem(linked_stops_.at(other), static_cast<StopPtr>(stop));
+            }
+        }
+        linked_stops_.erase(links);
+    }
+    stop_info_.erase(stop);
+    stops_.erase(it);
+    EraseItem(stop_order_, static_cast<StopPtr>(stop));
+
+    *stop = {};
+    free_stops_.push_back(stop);
+}
+
 const Stop* TransportCatalogue::GetStop(sv name) const {
-    if (stops_.count(name)){
-        return stops_.at(name);
+    auto it = stops_.find(name);
+    if (it != stops_.end()){
+        return it->second;
     }
     return nullptr;
 }
@@ -74,28 +265,82 @@ const StopInfo* TransportCatalogue::GetStopInfo(sv name) const {
     return &stop_info_.at(stop);
 }
 
-std::vector<StopPtr> TransportCatalogue::GetAllStops() const {
-    std::vector<StopPtr> result;
-    for (auto [stop, x] : stop_info_){
-        result.push_back(stop);
-    }
-    return result;
+TransportCatalogue::StopRange TransportCatalogue::GetAllStops() const {
+    return ranges::AsRange(stop_order_);
+}
+
+size_t TransportCatalogue::GetStopCount() const {
+    return stop_order_.size();
 }
 
 void TransportCatalogue::AddDistance(const Stop* from, const Stop* to, double road_distance){
 
-    double geo_distance = geo::ComputeDistance(from->coordinates, to->coordinates);
-    
-    distances_[{from, to}] = {geo_distance, road_distance};
+    SetDistance(from, to, {geo::ComputeDistance(from->coordinates, to->coordinates), road_distance});
+
+    UpdateBusInfo(from);
+}
+
+void TransportCatalogue::AddDistances(const Stop* from, const vector<pair<const Stop*, double>>& distances){
+    if (distances.empty()){
+        return;
+    }
+    vector<geo::Coordinates> targets;
+    targets.reserve(distances.size());
+    for (const auto& [to, road_distance] : distances){
+        targets.push_back(to->coordinates);
+    }
+    const vector<double> geo_distances = geo::ComputeDistances(from->coordinates, targets);
+    for (size_t index = 0; index < distances.size(); ++index){
+        SetDistance(from, distances[index].first, {geo_distances[index], distances[index].second});
+    }
+    UpdateBusInfo(from);
+}
+
+void TransportCatalogue::SetDistance(const Stop* from, const Stop* to, geo::Distance distance){
+    if (!distances_.count({from, to}) && !distances_.count({to, from})){
+        linked_stops_[from].push_back(to);
+        if (from != to){
+            linked_stops_[to].push_back(from);
+        }
+    }
+
+    distances_[{from, to}] = distance;
 
     if (from != to && !distances_.count({to, from})){
-        distances_[{to, from}] = {geo_distance, road_distance};
+        distances_[{to, from}] = distance;
+    }
+}
+
+void TransportCatalogue::RemoveDistance(const Stop* from, const Stop* to){
+    if (!distances_.count({from, to})){
+        return;
+    }
+    for (BusPtr bus : stop_info_.at(from).through_buses){
+        auto route = bus->GetRoute();
+        for (size_t index = 1; index < route.size(); ++index){
+            if (route[index - 1] == from && route[index] == to){
+                throw logic_error("Distance is used by bus "s + string(bus->name));
+            }
+        }
+    }
+    distances_.erase({from, to});
+
+    if (!distances_.count({to, from})){
+        EraseItem(linked_stops_.at(from), to);
+        if (from != to){
+            EraseItem(linked_stops_.at(to), from);
+        }
     }
 }
 
 geo::Distance TransportCatalogue::GetDistance(const Stop* from, const Stop* to) const {
     return distances_.at({from, to});
 }
+
+bool TransportCatalogue::HasDistance(const Stop* from, const Stop* to) const {
+    return distances_.count({from, to}) != 0;
+}
+
 void TransportCatalogue::SetRouteSettings(RouteSettings settings){
     route_settings_ = settings;
 }
@@ -104,6 +349,51 @@ RouteSettings TransportCatalogue::GetRouteSettings() const {
     return route_settings_;
 }
 
+void TransportCatalogue::Finalize(){
+    for (auto& [stop, stop_info] : stop_info_){
+        sort(stop_info.through_buses.begin(), stop_info.through_buses.end(), ByName);
+        stop_info.through_buses.shrink_to_fit();
+    }
+    is_finalized_ = true;
+}
+
+shared_ptr<const FrozenCatalogue> TransportCatalogue::Freeze() const {
+    return make_shared<const FrozenCatalogue>(*this);
+}
+
+memory::Report TransportCatalogue::GetMemoryUsage() const {
+    memory::Usage stops{memory::DequeBytes(stops_data_)
+                        + memory::VectorBytes(free_stops_)
+                        + memory::VectorBytes(stop_order_)
+                        + memory::HashTableBytes(stops_)
+                        + memory::HashTableBytes(stop_info_),
+                        stop_order_.size()};
+    for (const auto& [stop, stop_info] : stop_info_){
+        stops.bytes += memory::VectorBytes(stop_info.through_buses);
+    }
+
+    memory::Usage buses{memory::DequeBytes(buses_data_)
+                        + memory::VectorBytes(free_buses_)
+                        + memory::VectorBytes(bus_order_)
+                        + memory::HashTableBytes(buses_)
+                        + memory::HashTableBytes(bus_info_),
+                        bus_order_.size()};
+    for (const Bus& bus : buses_data_){
+        buses.bytes += memory::VectorBytes(bus.stops);
+    }
+
+    memory::Usage distances{memory::HashTableBytes(distances_) + memory::HashTableBytes(linked_stops_),
+                            distances_.size()};
+    for (const auto& [stop, links] : linked_stops_){
+        distances.bytes += memory::VectorBytes(links);
+    }
+
+    return {{"stops"s, stops},
+            {"buses"s, buses},
+            {"distances"s, distances},
+            {"names"s, names_->GetMemoryUsage()}};
+}
+
 void TransportCatalogue::AddBusInfo(const Bus* bus){
 
     double geo_length = 0;
@@ -113,7 +403,7 @@ void TransportCatalogue::AddBusInfo(const Bus* bus){
     unordered_set<sv> uniques;
 
     bool is_first = true;
-    for (auto stop : bus -> route){
+    for (auto stop : bus -> stops){
 
         uniques.emplace(stop->name);
 
@@ -128,22 +418,64 @@ void TransportCatalogue::AddBusInfo(const Bus* bus){
 
         geo_length += distance.geo;
         road_length += distance.road;
+        // Обратный ход: дорожные расстояния могут отличаться, географические совпадают
+        if (!bus->is_roundtrip){
+            road_length += GetDistance(from_to.second, from_to.first).road;
+        }
 
         from_to.first = from_to.second;
     }
+    if (!bus->is_roundtrip){
+        geo_length *= 2;
+    }
     double curvature = road_length / geo_length;
 
-    bus_info_[bus] = {bus->route.size()
+    bus_info_[bus] = {bus->GetRoute().size()
                     , uniques.size()
                     , road_length
                     , curvature};
 }
 
+// При начальной загрузке автобус дописывается в конец, списки сортируются один раз в Finalize()
 void TransportCatalogue::AddBusToThroughStops(BusPtr bus){
-    for (StopPtr stop : bus->route){
+    for (StopPtr stop : bus->stops){
 
-        StopInfo& stop_info = stop_info_[stop];
+        auto& buses = stop_info_[stop].through_buses;
 
-        stop_info.through_buses.emplace(bus->name);
+        if (!is_finalized_){
+            // Повтор остановки в маршруте встречается, пока добавляется тот же автобус
+            if (buses.empty() || buses.back() != bus){
+                buses.push_back(bus);
+            }
+            continue;
+        }
+        // Список упорядочен по имени, повтор остановки в маршруте находится тем же поиском
+        auto it = lower_bound(buses.begin(), buses.end(), bus, ByName);
+        if (it == buses.end() || *it != bus){
+            buses.insert(it, bus);
+        }
+    }
+}
+
+void TransportCatalogue::RemoveBusFromThroughStops(BusPtr bus){
+    for (StopPtr stop : bus->stops){
+
+        auto& buses = stop_info_.at(stop).through_buses;
+
+        auto it = is_finalized_ ? lower_bound(buses.begin(), buses.end(), bus, ByName)
+                                : find(buses.begin(), buses.end(), bus);
+        if (it != buses.end() && *it == bus){
+            buses.erase(it);
+        }
+    }
+}
+
+// При начальной загрузке расстояния и остановки задаются до автобусов, и пересчитывать нечего
+void TransportCatalogue::UpdateBusInfo(StopPtr stop){
+    if (!is_finalized_){
+        return;
+    }
+    for (BusPtr bus : stop_info_.at(stop).through_buses){
+        AddBusInfo(bus);
     }
 }
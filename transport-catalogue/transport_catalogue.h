@@ -2,8 +2,13 @@
 
 
 #include "domain.h"
+#include "frozen_catalogue.h"
+#include "memory_usage.h"
+#include "ranges.h"
+#include "string_pool.h"
 
 #include <deque>
+#include <memory>
 #include <unordered_map>
 
 class TransportCatalogue {
@@ -13,50 +18,128 @@ using DistancesInfo = std::unordered_map<std::pair<const Stop*, const Stop*>, ge
 
 
 public:
+	// Представления над списками в порядке добавления, без копирования
+	using BusRange = ranges::Range<std::vector<BusPtr>::const_iterator>;
+	using StopRange = ranges::Range<std::vector<StopPtr>::const_iterator>;
 	
 
-	TransportCatalogue() = default;
+	// Справочник со своим пулом имён
+	TransportCatalogue();
 
+	// Справочник, хранящий имена в общем пуле
+	explicit TransportCatalogue(std::shared_ptr<StringPool> names);
 
-	void AddBus(sv name, const std::vector<StopPtr>& route, const std::vector<StopPtr>& edge_stops);
+	// Копия с тем же пулом имён. Указатели на остановки и автобусы переводятся на свои.
+	TransportCatalogue(const TransportCatalogue& other);
+	TransportCatalogue& operator=(const TransportCatalogue&) = delete;
+	// При перемещении объекты остаются на месте, указатели на них не меняются
+	TransportCatalogue(TransportCatalogue&&) = default;
+	TransportCatalogue& operator=(TransportCatalogue&&) = default;
+
+
+	// Имя забирается в пул имён, если такого там ещё нет
+	void AddBus(std::string name, std::vector<StopPtr> stops, bool is_roundtrip);
+
+	// Добавляет автобус или заменяет маршрут существующего
+	void UpsertBus(sv name, std::vector<StopPtr> stops, bool is_roundtrip);
+
+	// Удаляет автобус. Неизвестное имя игнорируется.
+	void RemoveBus(sv name);
 
 	const Bus* GetBus(sv name) const;
 
 	const BusInfo* GetBusInfo(sv name) const;
 
-	std::vector<BusPtr> GetAllBuses() const;
+	BusRange GetAllBuses() const;
+
+	size_t GetBusCount() const;
 	
 
+	const Stop* AddStop(std::string name, geo::Coordinates coordinates);
+
+	// Имя копируется в пул имён, если такого там ещё нет
 	const Stop* AddStop(sv name, geo::Coordinates coordinates);
 
+	// Добавляет остановку или переносит существующую на новые координаты
+	const Stop* UpsertStop(sv name, geo::Coordinates coordinates);
+
+	// Удаляет остановку вместе с расстояниями от неё и до неё. Неизвестное имя игнорируется.
+	// Остановку, через которую проходят автобусы, удалить нельзя: бросает std::logic_error.
+	void RemoveStop(sv name);
+
 	const Stop* GetStop(sv name) const;
 
 	const StopInfo* GetStopInfo(sv name) const;
 
-	std::vector<StopPtr> GetAllStops() const;
+	StopRange GetAllStops() const;
 
+	size_t GetStopCount() const;
 
+
+	// Задаёт расстояние from -> to, а также to -> from, если оно ещё не задано
 	void AddDistance(StopPtr from, StopPtr to, double distance);
 
+	// То же для нескольких остановок to. Географические расстояния от from считаются одним пакетом.
+	void AddDistances(StopPtr from, const std::vector<std::pair<StopPtr, double>>& distances);
+
+	// Удаляет расстояние from -> to. Если по нему проходит маршрут, бросает std::logic_error.
+	void RemoveDistance(StopPtr from, StopPtr to);
+
 	geo::Distance GetDistance(StopPtr from, const StopPtr to) const;
 
+	// Задано ли расстояние from -> to
+	bool HasDistance(StopPtr from, StopPtr to) const;
+
 	void SetRouteSettings(RouteSettings settings);
 
 	RouteSettings GetRouteSettings() const;
 
+	// Завершает начальную загрузку: сортирует списки автобусов остановок и освобождает
+	// их лишнюю память. До вызова автобусы добавляются в конец списков, а информация
+	// об автобусах не пересчитывается при изменении расстояний и остановок.
+	void Finalize();
+
+	// Строит неизменяемый снимок для обработки запросов
+	std::shared_ptr<const FrozenCatalogue> Freeze() const;
+
+	// Память остановок, автобусов, таблицы расстояний и пула имён.
+	// Общий пул входит в отчёт каждого справочника, который его использует.
+	memory::Report GetMemoryUsage() const;
+
 private:
+	// Размещает остановку с именем из пула
+	const Stop* PlaceStop(sv name, geo::Coordinates coordinates);
+
+	// Расстояние без пересчёта информации об автобусах
+	void SetDistance(StopPtr from, StopPtr to, geo::Distance distance);
+
 	void AddBusInfo(BusPtr bus);
 
 	void AddBusToThroughStops(BusPtr bus);
 
+	void RemoveBusFromThroughStops(BusPtr bus);
+
+	// Пересчитывает информацию об автобусах, проходящих через остановку. До Finalize() ничего не делает.
+	void UpdateBusInfo(StopPtr stop);
+
+	// Ячейки удалённых объектов в *_data_ переиспользуются: указатели на живые объекты не меняются
 	std::deque<Bus> buses_data_;
-	std::unordered_map<sv, BusPtr> buses_;	
+	std::vector<Bus*> free_buses_;
+	std::vector<BusPtr> bus_order_;
+	std::unordered_map<sv, Bus*> buses_;	
 	std::unordered_map<BusPtr, BusInfo> bus_info_;
 
 	std::deque<Stop> stops_data_;
-	std::unordered_map<sv, StopPtr> stops_;
+	std::vector<Stop*> free_stops_;
+	std::vector<StopPtr> stop_order_;
+	std::unordered_map<sv, Stop*> stops_;
 	std::unordered_map<StopPtr, StopInfo> stop_info_;
 
 	DistancesInfo distances_;
+	// Остановки, с которыми у остановки задано расстояние в любую сторону
+	std::unordered_map<StopPtr, std::vector<StopPtr>> linked_stops_;
 	RouteSettings route_settings_;
+	bool is_finalized_ = false;
+
+	std::shared_ptr<StringPool> names_;
 };
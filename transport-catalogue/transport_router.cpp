@@ -1,7 +1,12 @@
 #include "transport_router.h"
+
+#include <algorithm>
+#include <limits>
+#include <queue>
+
 using namespace router;
 
-RoutePreBuilder::RoutePreBuilder(const TransportCatalogue& db)
+RoutePreBuilder::RoutePreBuilder(const FrozenCatalogue& db)
 : db_(db){
 }
 
@@ -10,23 +15,24 @@ const std::vector<Edge<double>>& RoutePreBuilder::GetAllEdges() const {
 }
 
 size_t RoutePreBuilder::GetVertexCount() const {
-    return db_.GetAllStops().size() * 2;
+    return db_.GetStopCount() * 2;
 }
 
 WayItem RoutePreBuilder::GetWayItem(EdgeId edge_id) const {
-    if (wait_edges_ids_.count(edge_id)){
-        WayItem item = {wait_edges_ids_.at(edge_id)->name,
+    size_t stop_edges_count = db_.GetStopCount() * 2;
+    if (edge_id < stop_edges_count && edge_id % 2 == 0){
+        WayItem item = {db_.GetStopName(static_cast<StopId>(edge_id / 2)),
                 "Wait",
                 wait_time_,
                 0};
         return item;
     }
-    if (ride_edges_ids_.count(edge_id)){
-        auto bus_info = ride_edges_ids_.at(edge_id);
-        WayItem item = {bus_info.bus->name,
+    if (edge_id >= stop_edges_count && edge_id - stop_edges_count < ride_edges_.size()){
+        const auto& ride_info = ride_edges_[edge_id - stop_edges_count];
+        WayItem item = {db_.GetBusName(ride_info.bus),
                 "Bus",
-                bus_info.time,
-                ride_edges_ids_.at(edge_id).span_count};
+                ride_info.time,
+                ride_info.span_count};
         return item;
     }
     throw ("Bad edge_id at GetWayItem()");
@@ -38,38 +44,46 @@ void RoutePreBuilder::FillGraph(DirectedWeightedGraph<double>& graph){
     }
 }
 
+memory::Usage RoutePreBuilder::GetMemoryUsage() const {
+    return {memory::VectorBytes(all_possible_edges_) + memory::VectorBytes(ride_edges_),
+            all_possible_edges_.size()};
+}
+
 void RoutePreBuilder::BuildData(){
     wait_time_ = db_.GetRouteSettings().wait_time;
     velocity_ = db_.GetRouteSettings().velocity;
-    auto all_stops = db_.GetAllStops();
-    for (StopPtr stop : all_stops){
+    all_possible_edges_.reserve(GetVertexCount());
+    for (StopId stop = 0; stop < db_.GetStopCount(); ++stop){
         AddStop(stop);
     }
-    auto all_buses = db_.GetAllBuses();
-    for (BusPtr bus : all_buses){
+    for (BusId bus = 0; bus < db_.GetBusCount(); ++bus){
         AddBus(bus);
     }
 }
 
-void RoutePreBuilder::AddStop(StopPtr stop){
-    Edge<double> edge = {current_vertex_id_,
-                        ++current_vertex_id_,
+VertexId RoutePreBuilder::OuterVertex(StopId stop){
+    return static_cast<VertexId>(stop) * 2;
+}
+
+VertexId RoutePreBuilder::InnerVertex(StopId stop){
+    return static_cast<VertexId>(stop) * 2 + 1;
+}
+
+void RoutePreBuilder::AddStop(StopId stop){
+    Edge<double> edge = {OuterVertex(stop),
+                        InnerVertex(stop),
                         wait_time_};
     Edge<double> reversed_edge = {edge.to,
                                 edge.from,
                                 0.0};
-    wait_edges_ids_[current_edge_id_++] = stop;
-    stops_vertexes_[stop] = {edge.from,
-                         edge.to};
     all_possible_edges_.push_back(edge);
     all_possible_edges_.push_back(reversed_edge);
-    ++current_edge_id_;
-    ++current_vertex_id_;
 }
 
-void RoutePreBuilder::AddBus(BusPtr bus){
-    auto route = bus->route;
-    size_t route_size = route.size();
+void RoutePreBuilder::AddBus(BusId bus){
+    auto stops = db_.GetBusRoute(bus);
+    size_t route_size = stops.size();
+    auto distances = db_.GetBusRouteDistances(bus).begin();
 
     if (route_size <= 1){
         return;
@@ -84,32 +98,44 @@ void RoutePreBuilder::AddBus(BusPtr bus){
         Edge<double> edge;
         for (size_t to_idx = from_idx + 1; to_idx < route_size; to_idx++){
             size_t span_count = to_idx - from_idx;
-            distance += db_.GetDistance(route[to_idx - 1], route[to_idx]).road;
+            distance += distances[to_idx - 1];
             double weight = compute_weight(distance);
-            edge = {stops_vertexes_.at(route[from_idx]).inner,
-                    stops_vertexes_.at(route[to_idx]).outer,
+            edge = {InnerVertex(stops[from_idx]),
+                    OuterVertex(stops[to_idx]),
                     weight};
-            ride_edges_ids_[current_edge_id_++] = {bus,
-                                                span_count,
-                                                weight};
+            ride_edges_.push_back({bus,
+                                span_count,
+                                weight});
             all_possible_edges_.push_back(edge);
         }
     }
 }
 
-RouteBuilder::RouteBuilder(const TransportCatalogue& db)
+RouteBuilder::RouteBuilder(const FrozenCatalogue& db)
 : db_(db){
 }
 void RouteBuilder::InitializeGraph() const {
-    data_ = new RoutePreBuilder(db_);
-    data_->BuildData();
-    graph_ptr_ = new DirectedWeightedGraph<double>(data_->GetVertexCount());
-    data_->FillGraph(*graph_ptr_);
-    router_ptr_ = new Router<double>(*graph_ptr_);
+    std::call_once(init_flag_, [this]{
+        data_ = new RoutePreBuilder(db_);
+        data_->BuildData();
+        graph_ptr_ = new DirectedWeightedGraph<double>(data_->GetVertexCount());
+        data_->FillGraph(*graph_ptr_);
+        router_ptr_ = new Router<double>(*graph_ptr_);
+        is_built_ = true;
+    });
 }
 
 bool RouteBuilder::IsReadyToBuild() const {
-    return (data_ && graph_ptr_ && router_ptr_);
+    return is_built_;
+}
+
+memory::Report RouteBuilder::GetMemoryUsage() const {
+    if (!is_built_){
+        return {{"route_data", {}}, {"graph", {}}, {"router", {}}};
+    }
+    return {{"route_data", data_->GetMemoryUsage()},
+            {"graph", graph_ptr_->GetMemoryUsage()},
+            {"router", router_ptr_->GetMemoryUsage()}};
 }
 
 RouteBuilder::~RouteBuilder(){
@@ -118,12 +144,13 @@ RouteBuilder::~RouteBuilder(){
         delete data_;
 
 }
-std::optional<Way> RouteBuilder::GetBestWay(StopPtr from, StopPtr to) const {
-    if (!data_->stops_vertexes_.count(from) || !data_->stops_vertexes_.count(to)){
+std::optional<Way> RouteBuilder::GetBestWay(StopId from, StopId to) const {
+    InitializeGraph();
+    if (from >= db_.GetStopCount() || to >= db_.GetStopCount()){
         return std::nullopt;
     }
-    VertexId from_id = data_->stops_vertexes_.at(from).outer;
-    VertexId to_id = data_->stops_vertexes_.at(to).outer;
+    VertexId from_id = RoutePreBuilder::OuterVertex(from);
+    VertexId to_id = RoutePreBuilder::OuterVertex(to);
 
     auto way_info = router_ptr_->BuildRoute(from_id, to_id);
     if (!way_info){
@@ -138,4 +165,81 @@ std::optional<Way> RouteBuilder::GetBestWay(StopPtr from, StopPtr to) const {
     }
     Way way = {total_time, route};
     return way;
-}
\ No newline at end of file
+}
+
+std::optional<Way> RouteBuilder::GetBestJourney(geo::Coordinates from, geo::Coordinates to) const {
+    InitializeGraph();
+    const RouteSettings settings = db_.GetRouteSettings();
+    // Время в минутах, скорость в км/ч
+    auto walk_time = [&settings](double distance){
+        return (distance / 1000.0) / (settings.pedestrian_velocity / 60);
+    };
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    // Время пешком от остановки до точки назначения
+    std::vector<double> finish_time(db_.GetStopCount(), infinity);
+    for (const auto& stop : db_.FindStopsInRadius(to, settings.walk_radius)){
+        finish_time[stop.index] = walk_time(stop.distance);
+    }
+
+    double best_time = infinity;
+    std::optional<StopId> best_stop;
+    const double direct_distance = geo::ComputeDistance(from, to);
+    if (direct_distance <= settings.walk_radius){
+        best_time = walk_time(direct_distance);
+    }
+
+    using QueueItem = std::pair<double, VertexId>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+    std::vector<double> times(graph_ptr_->GetVertexCount(), infinity);
+    std::vector<std::optional<EdgeId>> prev_edges(graph_ptr_->GetVertexCount());
+    for (const auto& stop : db_.FindStopsInRadius(from, settings.walk_radius)){
+        VertexId vertex = RoutePreBuilder::OuterVertex(stop.index);
+        times[vertex] = walk_time(stop.distance);
+        queue.push({times[vertex], vertex});
+    }
+
+    while (!queue.empty()){
+        auto [time, vertex] = queue.top();
+        queue.pop();
+        if (time > times[vertex]){
+            continue;
+        }
+        // Остальные вершины не ближе, улучшить найденный маршрут они не могут
+        if (time >= best_time){
+            break;
+        }
+        if (vertex % 2 == 0){
+            StopId stop = static_cast<StopId>(vertex / 2);
+            if (time + finish_time[stop] < best_time){
+                best_time = time + finish_time[stop];
+                best_stop = stop;
+            }
+        }
+        for (EdgeId edge_id : graph_ptr_->GetIncidentEdges(vertex)){
+            const auto& edge = graph_ptr_->GetEdge(edge_id);
+            if (time + edge.weight < times[edge.to]){
+                times[edge.to] = time + edge.weight;
+                prev_edges[edge.to] = edge_id;
+                queue.push({times[edge.to], edge.to});
+            }
+        }
+    }
+
+    if (best_time == infinity){
+        return std::nullopt;
+    }
+    if (!best_stop){
+        return Way{best_time, {{sv(), "Walk", best_time, 0}}};
+    }
+
+    std::vector<WayItem> route;
+    route.push_back({sv(), "Walk", finish_time[*best_stop], 0});
+    VertexId vertex = RoutePreBuilder::OuterVertex(*best_stop);
+    for (; prev_edges[vertex]; vertex = graph_ptr_->GetEdge(*prev_edges[vertex]).from){
+        route.push_back(data_->GetWayItem(*prev_edges[vertex]));
+    }
+    route.push_back({db_.GetStopName(static_cast<StopId>(vertex / 2)), "Walk", times[vertex], 0});
+    std::reverse(route.begin(), route.end());
+    return Way{best_time, std::move(route)};
+}
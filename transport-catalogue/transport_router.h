@@ -1,18 +1,23 @@
 #pragma once
 
+#include "frozen_catalogue.h"
 #include "graph.h"
 #include "router.h"
-#include "transport_catalogue.h"
+
+#include <atomic>
+#include <mutex>
 
 namespace router{
 using namespace graph;
 
 struct RideInfo{
-    BusPtr bus;
+    BusId bus;
     size_t span_count;
     double time;
 };
 
+// Для ожидания name — остановка, для поездки — автобус,
+// для пешего участка — остановка, к которой он ведёт (пусто, если к точке назначения)
 struct WayItem{
     sv name;
     std::string type;
@@ -30,47 +35,56 @@ class RoutePreBuilder{
 public:
     friend class RouteBuilder;
 
-    RoutePreBuilder(const TransportCatalogue& db);
+    RoutePreBuilder(const FrozenCatalogue& db);
     void BuildData();
     const std::vector<Edge<double>>& GetAllEdges() const;
     size_t GetVertexCount() const;
     WayItem GetWayItem(EdgeId edge_id) const;
     void FillGraph(DirectedWeightedGraph<double>& graph);
+    memory::Usage GetMemoryUsage() const;
 
     
 private:
-    void AddStop(StopPtr stop);
-    void AddBus(BusPtr bus);
+    // Остановке id соответствуют вершины 2 * id (прибытие) и 2 * id + 1 (посадка),
+    // и рёбра ожидания с теми же номерами. Рёбра поездок нумеруются следом.
+    static VertexId OuterVertex(StopId stop);
+    static VertexId InnerVertex(StopId stop);
 
-    struct StopVertexes {
-        VertexId outer;
-        VertexId inner;
-    };
+    void AddStop(StopId stop);
+    void AddBus(BusId bus);
 
     double velocity_ = 0;
     double wait_time_ = 0;
-    const TransportCatalogue& db_;
+    const FrozenCatalogue& db_;
 
-    VertexId current_vertex_id_ = 0;
-    EdgeId current_edge_id_ = 0;
-    std::unordered_map<EdgeId, StopPtr> wait_edges_ids_;
-    std::unordered_map<EdgeId, RideInfo> ride_edges_ids_;
-    std::unordered_map<StopPtr, StopVertexes> stops_vertexes_;
+    std::vector<RideInfo> ride_edges_;
 
     std::vector<Edge<double>> all_possible_edges_;
 };
 
 class RouteBuilder{
 public:
-    RouteBuilder(const TransportCatalogue& db);
+    RouteBuilder(const FrozenCatalogue& db);
+    // Строит граф при первом вызове, повторные вызовы ничего не делают
     void InitializeGraph() const;
-    std::optional<Way> GetBestWay(StopPtr from, StopPtr to) const;
+    std::optional<Way> GetBestWay(StopId from, StopId to) const;
+
+    // Маршрут между произвольными точками. Пешком можно дойти до остановок в радиусе
+    // walk_radius от from и уйти от остановок в радиусе walk_radius от to. Поиск —
+    // один проход Дейкстры из всех начальных остановок сразу до ближайшей конечной.
+    std::optional<Way> GetBestJourney(geo::Coordinates from, geo::Coordinates to) const;
 
     bool IsReadyToBuild() const;
 
+    // Память данных для построения графа, самого графа и матрицы маршрутизатора.
+    // До построения графа все составляющие нулевые.
+    memory::Report GetMemoryUsage() const;
+
     ~RouteBuilder();
 private:
-    const TransportCatalogue& db_;
+    const FrozenCatalogue& db_;
+    mutable std::once_flag init_flag_;
+    mutable std::atomic<bool> is_built_ = false;
     mutable RoutePreBuilder* data_ = nullptr;
     mutable graph::DirectedWeightedGraph<double>* graph_ptr_ = nullptr;
     mutable graph::Router<double>* router_ptr_ = nullptr;
@@ -0,0 +1,55 @@
+#include "versioned_catalogue.h"
+
+#include <utility>
+
+using namespace std;
+
+CatalogueVersion::CatalogueVersion(uint64_t number_, shared_ptr<const FrozenCatalogue> catalogue_,
+                                   const renderer::Settings& render_settings, memory::Report source_memory_)
+: number(number_)
+, catalogue(std::move(catalogue_))
+, source_memory(std::move(source_memory_))
+, renderer(*catalogue, render_settings)
+, router(*catalogue)
+, handler(*catalogue, renderer, router, source_memory){
+}
+
+VersionedCatalogue::VersionedCatalogue(bool warm_up_router, shared_ptr<StringPool> names)
+: warm_up_router_(warm_up_router)
+, db_(names ? std::move(names) : make_shared<StringPool>()){
+    lock_guard guard(writer_mutex_);
+    Publish();
+}
+
+shared_ptr<const CatalogueVersion> VersionedCatalogue::Pin() const {
+    return atomic_load(&current_);
+}
+
+uint64_t VersionedCatalogue::Update(const Updater& updater){
+    lock_guard guard(writer_mutex_);
+    // Изменения вносятся в копию и принимаются, только если updater завершился без исключения
+    TransportCatalogue db(db_);
+    renderer::Settings render_settings = render_settings_;
+    updater(db, render_settings);
+    db_ = std::move(db);
+    render_settings_ = std::move(render_settings);
+    Publish();
+    return last_number_;
+}
+
+future<uint64_t> VersionedCatalogue::UpdateAsync(Updater updater){
+    return async(launch::async, [this, updater = std::move(updater)]{
+        return Update(updater);
+    });
+}
+
+// Вызывается под writer_mutex_. Старая версия освобождается последним читателем.
+// Freeze() полностью перестраивает снимок, изменённые части отдельно не отслеживаются.
+void VersionedCatalogue::Publish(){
+    auto version = make_shared<const CatalogueVersion>(++last_number_, db_.Freeze(), render_settings_,
+                                                     db_.GetMemoryUsage());
+    if (warm_up_router_){
+        version->router.InitializeGraph();
+    }
+    atomic_store(&current_, std::move(version));
+}
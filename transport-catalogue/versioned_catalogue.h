@@ -0,0 +1,69 @@
+#pragma once
+
+#include "frozen_catalogue.h"
+#include "map_renderer.h"
+#include "request_handler.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+
+// Версия справочника: снимок и построенные по нему визуализатор, маршрутизатор
+// и обработчик запросов. Версия неизменяема и удаляется, когда на неё не остаётся ссылок.
+struct CatalogueVersion {
+    CatalogueVersion(uint64_t number_, std::shared_ptr<const FrozenCatalogue> catalogue_,
+                     const renderer::Settings& render_settings, memory::Report source_memory_);
+
+    uint64_t number;
+    std::shared_ptr<const FrozenCatalogue> catalogue;
+    // Снята под блокировкой писателя: читатели не обращаются к изменяемому справочнику
+    memory::Report source_memory;
+    renderer::MapRenderer renderer;
+    router::RouteBuilder router;
+    RequestHandler handler;
+};
+
+// Справочник с атомарной заменой версий (RCU).
+// Читатели закрепляют текущую версию через Pin() и работают с ней без блокировок.
+// Писатели по очереди изменяют справочник, строят по нему новую версию
+// и публикуют её одной атомарной операцией.
+class VersionedCatalogue {
+public:
+    using Updater = std::function<void(TransportCatalogue& db, renderer::Settings& render_settings)>;
+
+    // warm_up_router — строить граф маршрутов до публикации версии,
+    // чтобы первый запрос Route к ней не ждал построения
+    // names — общий пул имён, по умолчанию у справочника свой
+    explicit VersionedCatalogue(bool warm_up_router = true, std::shared_ptr<StringPool> names = nullptr);
+
+    std::shared_ptr<const CatalogueVersion> Pin() const;
+
+    // Применяет изменения и публикует новую версию. Возвращает её номер.
+    // updater получает копию справочника, которая заменяет текущий только при успехе:
+    // если updater бросает исключение, справочник не меняется и версия не публикуется.
+    // Ссылки на справочник, полученные в updater, после возврата недействительны.
+    // Копия и снимок новой версии строятся по всему справочнику: стоимость публикации
+    // O(размер справочника) независимо от объёма изменений.
+    uint64_t Update(const Updater& updater);
+
+    // То же, что Update(), но в отдельном потоке. Одновременные вызовы выполняются по очереди
+    // в произвольном порядке: нужный порядок изменений обеспечивает вызывающий,
+    // например дожидаясь результата предыдущего вызова.
+    std::future<uint64_t> UpdateAsync(Updater updater);
+
+private:
+    void Publish();
+
+    bool warm_up_router_;
+
+    std::mutex writer_mutex_;
+    TransportCatalogue db_;
+    renderer::Settings render_settings_;
+    uint64_t last_number_ = 0;
+
+    std::shared_ptr<const CatalogueVersion> current_;
+};